@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace lab04 {
+
+// Bounds for what a request takes from an Arena: arena_footprint() in
+// figure.hpp, where snapshot_footprint() is declared in the same terms.
+
+// Bump allocator over one block sized up front. Deallocation is a no-op;
+// everything is released together when the arena is destroyed. Requests
+// that no longer fit go to `upstream` in separate blocks, so an estimate
+// that was too small costs extra allocations, never correctness.
+class Arena : public std::pmr::memory_resource {
+public:
+    explicit Arena(std::size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream_(upstream), capacity_(capacity) {
+        if (capacity_ > 0) {
+            block_ = static_cast<std::byte*>(upstream_->allocate(capacity_, alignof(std::max_align_t)));
+        }
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() override {
+        for (const auto& overflow : overflow_) {
+            upstream_->deallocate(overflow.data, overflow.size, overflow.alignment);
+        }
+        if (block_ != nullptr) {
+            upstream_->deallocate(block_, capacity_, alignof(std::max_align_t));
+        }
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+    [[nodiscard]] std::size_t used() const noexcept { return used_; }
+    [[nodiscard]] std::size_t overflow_blocks() const noexcept { return overflow_.size(); }
+
+private:
+    struct Overflow {
+        void* data;
+        std::size_t size;
+        std::size_t alignment;
+    };
+
+    std::pmr::memory_resource* upstream_;
+    std::byte* block_{nullptr};
+    std::size_t capacity_{0};
+    std::size_t used_{0};
+    std::vector<Overflow> overflow_;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (block_ != nullptr) {
+            const auto address = reinterpret_cast<std::uintptr_t>(block_) + used_;
+            const auto padding = (alignment - address % alignment) % alignment;
+            if (padding + bytes <= capacity_ - used_) {
+                used_ += padding + bytes;
+                return block_ + (used_ - bytes);
+            }
+        }
+        overflow_.reserve(overflow_.size() + 1);
+        void* data = upstream_->allocate(bytes, alignment);
+        overflow_.push_back(Overflow{data, bytes, alignment});
+        return data;
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+}  // namespace lab04
@@ -1,15 +1,53 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <concepts>
 #include <cstddef>
 #include <initializer_list>
 #include <memory>
+#include <ranges>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
+#include "instrumentation.hpp"
+
 namespace lab04 {
 
-template <typename T>
+// Growth policies decide the capacity an array grows to once `required`
+// elements no longer fit into `current`.
+template <typename Policy>
+concept GrowthPolicy = requires(std::size_t current, std::size_t required) {
+    { Policy::next_capacity(current, required) } -> std::convertible_to<std::size_t>;
+};
+
+struct DoublingGrowth {
+    static constexpr std::size_t next_capacity(std::size_t current, std::size_t required) noexcept {
+        return current == 0 ? required : std::max(required, current * 2);
+    }
+};
+
+struct HalfStepGrowth {
+    static constexpr std::size_t next_capacity(std::size_t current, std::size_t required) noexcept {
+        return current == 0 ? required : std::max(required, current + current / 2);
+    }
+};
+
+template <std::size_t Chunk>
+struct ChunkGrowth {
+    static_assert(Chunk > 0, "chunk size must be positive");
+
+    static constexpr std::size_t next_capacity(std::size_t, std::size_t required) noexcept {
+        return (required + Chunk - 1) / Chunk * Chunk;
+    }
+};
+
+// Contiguous array of default-constructible elements; vacated slots are
+// reset to value_type{}. With Inline > 0 up to that many elements live
+// inside the object, and the allocator is only touched once it grows past
+// them (see SmallArray below).
+template <typename T, GrowthPolicy Growth = DoublingGrowth, std::size_t Inline = 0>
 class Array {
 public:
     using value_type = T;
@@ -21,6 +59,8 @@ public:
     using iterator = pointer;
     using const_iterator = const_pointer;
 
+    static constexpr size_type inline_capacity = Inline;
+
     Array() = default;
 
     explicit Array(size_type initial_capacity) {
@@ -52,16 +92,14 @@ public:
         return *this;
     }
 
-    Array(Array&& other) noexcept
-        : size_(std::exchange(other.size_, 0)),
-          capacity_(std::exchange(other.capacity_, 0)),
-          storage_(std::move(other.storage_)) {}
+    Array(Array&& other) noexcept(kNothrowMove) { take(std::move(other)); }
 
-    Array& operator=(Array&& other) noexcept {
+    Array& operator=(Array&& other) noexcept(kNothrowMove) {
         if (this != &other) {
-            storage_ = std::move(other.storage_);
-            size_ = std::exchange(other.size_, 0);
-            capacity_ = std::exchange(other.capacity_, 0);
+            clear();
+            storage_.reset();
+            capacity_ = Inline;
+            take(std::move(other));
         }
         return *this;
     }
@@ -71,6 +109,7 @@ public:
     [[nodiscard]] size_type size() const noexcept { return size_; }
     [[nodiscard]] size_type capacity() const noexcept { return capacity_; }
     [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] bool is_inline() const noexcept { return storage_ == nullptr; }
 
     reference operator[](size_type index) {
         if (index >= size_) {
@@ -114,8 +153,21 @@ public:
         return (*this)[size_ - 1];
     }
 
-    pointer data() noexcept { return storage_.get(); }
-    const_pointer data() const noexcept { return storage_.get(); }
+    pointer data() noexcept {
+        if constexpr (Inline == 0) {
+            return storage_.get();
+        } else {
+            return storage_ ? storage_.get() : inline_.data();
+        }
+    }
+
+    const_pointer data() const noexcept {
+        if constexpr (Inline == 0) {
+            return storage_.get();
+        } else {
+            return storage_ ? storage_.get() : inline_.data();
+        }
+    }
 
     iterator begin() noexcept { return data(); }
     const_iterator begin() const noexcept { return data(); }
@@ -139,26 +191,28 @@ public:
         if (new_capacity <= capacity_) {
             return;
         }
+        reallocate(new_capacity);
+    }
 
-        auto new_storage = std::shared_ptr<value_type[]>(
-            new value_type[new_capacity], std::default_delete<value_type[]>());
-
-        const auto old_ptr = data();
-        const auto new_ptr = new_storage.get();
-        for (size_type i = 0; i < size_; ++i) {
-            new_ptr[i] = std::move(old_ptr[i]);
+    // Sets the capacity to exactly max(new_capacity, size()), shrinking if
+    // needed; anything that fits into Inline moves back into the object.
+    void reserve_exact(size_type new_capacity) {
+        new_capacity = std::max(new_capacity, size_);
+        if (new_capacity != capacity_) {
+            reallocate(new_capacity);
         }
-
-        storage_ = std::move(new_storage);
-        capacity_ = new_capacity;
     }
 
+    void shrink_to_fit() { reserve_exact(size_); }
+
     void push_back(const value_type& value) {
+        LAB04_TRACE_SCOPE("Array::push_back");
         ensure_capacity(size_ + 1);
         data()[size_++] = value;
     }
 
     void push_back(value_type&& value) {
+        LAB04_TRACE_SCOPE("Array::push_back");
         ensure_capacity(size_ + 1);
         data()[size_++] = std::move(value);
     }
@@ -180,6 +234,7 @@ public:
     }
 
     void erase(size_type index) {
+        LAB04_TRACE_SCOPE("Array::erase");
         if (index >= size_) {
             throw std::out_of_range("Array index out of range");
         }
@@ -191,29 +246,92 @@ public:
         ptr[size_] = value_type{};
     }
 
-    void swap(Array& other) noexcept {
-        std::swap(storage_, other.storage_);
-        std::swap(size_, other.size_);
-        std::swap(capacity_, other.capacity_);
+    void swap(Array& other) noexcept(kNothrowMove) {
+        if constexpr (Inline == 0) {
+            std::swap(storage_, other.storage_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+        } else {
+            Array tmp{std::move(other)};
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
     }
 
 private:
+    static constexpr bool kNothrowMove = Inline == 0 || std::is_nothrow_move_assignable_v<value_type>;
+
     size_type size_{0};
-    size_type capacity_{0};
+    size_type capacity_{Inline};
     std::shared_ptr<value_type[]> storage_{};
+    [[no_unique_address]] std::array<value_type, Inline> inline_{};
 
     void ensure_capacity(size_type target) {
         if (target <= capacity_) {
             return;
         }
-        const auto new_capacity = capacity_ == 0 ? target : std::max(target, capacity_ * 2);
-        reserve(new_capacity);
+        reserve(std::max<size_type>(target, Growth::next_capacity(capacity_, target)));
+    }
+
+    void reallocate(size_type new_capacity) {
+        if (new_capacity <= Inline) {
+            if constexpr (Inline > 0) {
+                for (size_type i = 0; storage_ && i < size_; ++i) {
+                    inline_[i] = std::move(storage_[i]);
+                }
+            }
+            storage_.reset();
+            capacity_ = Inline;
+            return;
+        }
+
+        auto new_storage = std::shared_ptr<value_type[]>(
+            new value_type[new_capacity], std::default_delete<value_type[]>());
+
+        const auto old_ptr = data();
+        const auto new_ptr = new_storage.get();
+        for (size_type i = 0; i < size_; ++i) {
+            new_ptr[i] = std::move(old_ptr[i]);
+        }
+        if constexpr (Inline > 0) {
+            for (size_type i = 0; !storage_ && i < size_; ++i) {
+                inline_[i] = value_type{};
+            }
+        }
+
+        storage_ = std::move(new_storage);
+        capacity_ = new_capacity;
+    }
+
+    // Takes the contents of `other`, leaving it empty: the heap block
+    // changes hands, inline elements are moved one by one.
+    void take(Array&& other) {
+        if (other.storage_ || Inline == 0) {
+            storage_ = std::move(other.storage_);
+            capacity_ = std::exchange(other.capacity_, Inline);
+        } else if constexpr (Inline > 0) {
+            for (size_type i = 0; i < other.size_; ++i) {
+                inline_[i] = std::move(other.inline_[i]);
+                other.inline_[i] = value_type{};
+            }
+        }
+        size_ = std::exchange(other.size_, 0);
     }
 };
 
-template <typename T>
-void swap(Array<T>& lhs, Array<T>& rhs) noexcept {
+template <typename T, typename Growth, std::size_t Inline>
+void swap(Array<T, Growth, Inline>& lhs, Array<T, Growth, Inline>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
     lhs.swap(rhs);
 }
 
+// Array keeping up to N elements inside the object, for short lists built
+// per request or per call without a heap allocation.
+template <typename T, std::size_t N, GrowthPolicy Growth = DoublingGrowth>
+using SmallArray = Array<T, Growth, N>;
+
+static_assert(std::ranges::contiguous_range<Array<int>>);
+static_assert(std::ranges::sized_range<Array<int>>);
+static_assert(std::ranges::contiguous_range<const Array<int>>);
+static_assert(std::ranges::contiguous_range<SmallArray<int, 4>>);
+
 }  // namespace lab04
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#include "polygon.hpp"
+
+namespace lab04 {
+
+// Base for axis-aligned rectangular figures. Only the two opposite corners
+// are stored; vertices are produced on demand in the same counter-clockwise
+// order PolygonFigure used (starting at the lower-left corner), and area,
+// center and containment are evaluated in closed form.
+template <typename Derived, Scalar T>
+class AxisAlignedFigure : public Figure<T> {
+public:
+    using point_type = Point<T>;
+
+    AxisAlignedFigure() = default;
+    AxisAlignedFigure(const AxisAlignedFigure&) = default;
+    AxisAlignedFigure& operator=(const AxisAlignedFigure&) = default;
+    AxisAlignedFigure(AxisAlignedFigure&&) noexcept = default;
+    AxisAlignedFigure& operator=(AxisAlignedFigure&&) noexcept = default;
+    ~AxisAlignedFigure() override = default;
+
+    [[nodiscard]] point_type center() const override {
+        using real = std::common_type_t<T, double>;
+        return point_type{
+            static_cast<T>((static_cast<real>(min_x_) + static_cast<real>(max_x_)) / static_cast<real>(2)),
+            static_cast<T>((static_cast<real>(min_y_) + static_cast<real>(max_y_)) / static_cast<real>(2))};
+    }
+
+    [[nodiscard]] double area() const override {
+        LAB04_TRACE_SCOPE("AxisAlignedFigure::area");
+        using real = std::common_type_t<T, double>;
+        return static_cast<double>((static_cast<real>(max_x_) - static_cast<real>(min_x_)) *
+                                   (static_cast<real>(max_y_) - static_cast<real>(min_y_)));
+    }
+
+    void print(std::ostream& os) const override {
+        const auto previous_flags = os.flags();
+        const auto previous_precision = os.precision();
+
+        os << static_cast<const Derived*>(this)->shape_name() << ": ";
+        os << "vertices=[";
+        for (std::size_t i = 0; i < 4; ++i) {
+            os << vertex(i);
+            if (i + 1 < 4) {
+                os << ", ";
+            }
+        }
+        os << "], center=" << center() << ", area=" << std::fixed << std::setprecision(3) << area();
+
+        os.flags(previous_flags);
+        os.precision(previous_precision);
+    }
+
+    [[nodiscard]] std::unique_ptr<Figure<T>> clone() const override {
+        LAB04_TRACE_SCOPE("AxisAlignedFigure::clone");
+        return std::make_unique<Derived>(*static_cast<const Derived*>(this));
+    }
+
+    [[nodiscard]] std::size_t snapshot_footprint() const override { return arena_footprint<Derived>(); }
+
+    [[nodiscard]] Figure<T>* clone_into(std::pmr::memory_resource& resource) const override {
+        void* memory = resource.allocate(sizeof(Derived), alignof(Derived));
+        return ::new (memory) Derived(*static_cast<const Derived*>(this));
+    }
+
+    // Constructs a Derived centered at `center` in `resource` without any
+    // validation; bulk factories check their rows up front.
+    [[nodiscard]] static Derived* place_centered(std::pmr::memory_resource& resource, const point_type& center,
+                                                 T width, T height) {
+        void* memory = resource.allocate(sizeof(Derived), alignof(Derived));
+        auto* figure = ::new (memory) Derived();
+        static_cast<AxisAlignedFigure&>(*figure).assign_centered(center, width, height);
+        return figure;
+    }
+
+    [[nodiscard]] std::size_t vertex_count() const override { return 4; }
+
+    [[nodiscard]] point_type vertex(std::size_t index) const override {
+        switch (index) {
+            case 0:
+                return point_type{min_x_, min_y_};
+            case 1:
+                return point_type{max_x_, min_y_};
+            case 2:
+                return point_type{max_x_, max_y_};
+            case 3:
+                return point_type{min_x_, max_y_};
+            default:
+                throw std::out_of_range("vertex index out of range");
+        }
+    }
+
+    [[nodiscard]] bool contains(const point_type& point) const override {
+        return point.x() >= min_x_ && point.x() <= max_x_ && point.y() >= min_y_ && point.y() <= max_y_;
+    }
+
+    [[nodiscard]] std::array<point_type, 4> vertices() const {
+        return {vertex(0), vertex(1), vertex(2), vertex(3)};
+    }
+
+    [[nodiscard]] double width() const {
+        using real = std::common_type_t<T, double>;
+        return static_cast<double>(static_cast<real>(max_x_) - static_cast<real>(min_x_));
+    }
+
+    [[nodiscard]] double height() const {
+        using real = std::common_type_t<T, double>;
+        return static_cast<double>(static_cast<real>(max_y_) - static_cast<real>(min_y_));
+    }
+
+protected:
+    T min_x_{};
+    T min_y_{};
+    T max_x_{};
+    T max_y_{};
+
+    void assign_bounds(T min_x, T min_y, T max_x, T max_y) noexcept {
+        min_x_ = min_x;
+        min_y_ = min_y;
+        max_x_ = max_x;
+        max_y_ = max_y;
+    }
+
+    // Computes the corners exactly like the former vertex-based constructors
+    // so coordinates stay identical for integral and floating-point T.
+    void assign_centered(const point_type& center, T width, T height) {
+        using real = std::common_type_t<T, double>;
+        const auto half_width = static_cast<real>(width) / static_cast<real>(2);
+        const auto half_height = static_cast<real>(height) / static_cast<real>(2);
+        const auto cx = static_cast<real>(center.x());
+        const auto cy = static_cast<real>(center.y());
+        assign_bounds(static_cast<T>(cx - half_width), static_cast<T>(cy - half_height),
+                      static_cast<T>(cx + half_width), static_cast<T>(cy + half_height));
+    }
+
+    [[nodiscard]] static bool is_axis_aligned(const std::array<point_type, 4>& points) {
+        return points[0].y() == points[1].y() && points[1].x() == points[2].x() &&
+               points[2].y() == points[3].y() && points[3].x() == points[0].x() &&
+               points[1].x() > points[0].x() && points[2].y() > points[1].y();
+    }
+
+    [[nodiscard]] bool is_equal(const Figure<T>& other) const override {
+        const auto* other_ptr = dynamic_cast<const Derived*>(&other);
+        if (!other_ptr) {
+            return false;
+        }
+        return almost_equal(min_x_, other_ptr->min_x_) && almost_equal(min_y_, other_ptr->min_y_) &&
+               almost_equal(max_x_, other_ptr->max_x_) && almost_equal(max_y_, other_ptr->max_y_);
+    }
+};
+
+}  // namespace lab04
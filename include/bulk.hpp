@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "arena.hpp"
+#include "array.hpp"
+#include "figure.hpp"
+#include "rectangle.hpp"
+#include "snapshot.hpp"
+#include "square.hpp"
+#include "triangle.hpp"
+
+namespace lab04 {
+
+struct BulkReport {
+    std::size_t accepted{0};
+    std::vector<std::size_t> rejected;
+};
+
+namespace detail {
+
+// Flags the rows whose size columns (all but the two center columns) are
+// strictly positive; NaN fails too. Each column is one branch-free loop the
+// compiler vectorizes.
+template <Scalar T, std::size_t N>
+std::vector<unsigned char> positive_rows(const std::array<std::span<const T>, N>& columns) {
+    const auto rows = columns[0].size();
+    for (const auto& column : columns) {
+        if (column.size() != rows) {
+            throw std::invalid_argument("bulk columns differ in length");
+        }
+    }
+    std::vector<unsigned char> valid(rows, 1);
+    for (std::size_t c = 2; c < N; ++c) {
+        const T* values = columns[c].data();
+        unsigned char* flags = valid.data();
+        for (std::size_t i = 0; i < rows; ++i) {
+            flags[i] &= static_cast<unsigned char>(values[i] > T{0});
+        }
+    }
+    return valid;
+}
+
+// Appends one figure per valid row to `figures`. All of them, vertices
+// included, are placed in a single arena block shared by the returned
+// pointers, sized from `footprint` bytes per figure.
+template <Scalar T, typename Growth, typename Place>
+BulkReport append_rows(Array<std::shared_ptr<Figure<T>>, Growth>& figures, const std::vector<unsigned char>& valid,
+                       std::size_t footprint, Place place) {
+    BulkReport report;
+    for (std::size_t i = 0; i < valid.size(); ++i) {
+        report.accepted += valid[i];
+    }
+    report.rejected.reserve(valid.size() - report.accepted);
+    for (std::size_t i = 0; i < valid.size(); ++i) {
+        if (!valid[i]) {
+            report.rejected.push_back(i);
+        }
+    }
+    if (report.accepted == 0) {
+        return report;
+    }
+
+    auto block = std::make_shared<SnapshotBlock<T>>(arena_footprint<Figure<T>*>(report.accepted) +
+                                                    report.accepted * footprint);
+    block->reserve_table(report.accepted);
+    figures.reserve(figures.size() + report.accepted);
+    std::size_t slot = 0;
+    for (std::size_t i = 0; i < valid.size(); ++i) {
+        if (valid[i]) {
+            figures.push_back(std::shared_ptr<Figure<T>>(block, block->adopt(slot++, place(block->arena(), i))));
+        }
+    }
+    return report;
+}
+
+}  // namespace detail
+
+// Bulk factories: build one figure per row of parameter columns, equal to
+// what the per-figure constructors produce. Validation runs up front as one
+// pass over the size columns; rows with a non-positive (or NaN) size are
+// skipped and their indices reported in BulkReport::rejected. Columns of
+// different length throw std::invalid_argument. Accepted figures are
+// appended to `figures` in row order and share one arena allocation,
+// released when the last of them goes away.
+template <Scalar T, typename Growth>
+BulkReport append_squares(Array<std::shared_ptr<Figure<T>>, Growth>& figures, std::span<const T> center_x,
+                          std::span<const T> center_y, std::span<const T> side) {
+    const auto valid = detail::positive_rows<T, 3>({center_x, center_y, side});
+    return detail::append_rows(figures, valid, arena_footprint<Square<T>>(),
+                               [&](std::pmr::memory_resource& arena, std::size_t i) {
+                                   return Square<T>::place_centered(arena, Point<T>{center_x[i], center_y[i]},
+                                                                    side[i], side[i]);
+                               });
+}
+
+template <Scalar T, typename Growth>
+BulkReport append_rectangles(Array<std::shared_ptr<Figure<T>>, Growth>& figures, std::span<const T> center_x,
+                             std::span<const T> center_y, std::span<const T> width, std::span<const T> height) {
+    const auto valid = detail::positive_rows<T, 4>({center_x, center_y, width, height});
+    return detail::append_rows(figures, valid, arena_footprint<Rectangle<T>>(),
+                               [&](std::pmr::memory_resource& arena, std::size_t i) {
+                                   return Rectangle<T>::place_centered(arena, Point<T>{center_x[i], center_y[i]},
+                                                                       width[i], height[i]);
+                               });
+}
+
+template <Scalar T, typename Growth>
+BulkReport append_triangles(Array<std::shared_ptr<Figure<T>>, Growth>& figures, std::span<const T> center_x,
+                            std::span<const T> center_y, std::span<const T> base_width, std::span<const T> height) {
+    const auto valid = detail::positive_rows<T, 4>({center_x, center_y, base_width, height});
+    const auto footprint = arena_footprint<Triangle<T>>() + 3 * arena_footprint<Point<T>>();
+    return detail::append_rows(figures, valid, footprint, [&](std::pmr::memory_resource& arena, std::size_t i) {
+        return Triangle<T>::place_vertices(
+            arena, Triangle<T>::centered_vertices(Point<T>{center_x[i], center_y[i]}, base_width[i], height[i]));
+    });
+}
+
+}  // namespace lab04
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "array.hpp"
+#include "figure.hpp"
+#include "predicates.hpp"
+#include "task_executor.hpp"
+
+namespace lab04 {
+
+struct Circle {
+    Point<double> center{};
+    double radius{0.0};
+
+    [[nodiscard]] bool contains(const Point<double>& point, double tolerance = 1e-12) const {
+        const auto distance = std::hypot(point.x() - center.x(), point.y() - center.y());
+        return distance <= radius + tolerance * std::max(1.0, radius);
+    }
+};
+
+namespace detail {
+
+// Akl-Toussaint heuristic: drops every point strictly inside the octagon
+// spanned by the extreme points in x, y, x+y and x-y. For spread-out input
+// this removes almost everything before the O(n log n) sort.
+template <Scalar T>
+void discard_interior(std::vector<Point<T>>& points) {
+    if (points.size() < 16) {
+        return;
+    }
+    using real = std::common_type_t<T, double>;
+    const auto key = [](const Point<T>& p, int direction) {
+        const auto x = static_cast<real>(p.x());
+        const auto y = static_cast<real>(p.y());
+        switch (direction) {
+            case 0: return y;        // bottom
+            case 1: return -(x - y); // bottom-right
+            case 2: return -x;       // right
+            case 3: return -(x + y); // top-right
+            case 4: return -y;       // top
+            case 5: return x - y;    // top-left
+            case 6: return x;        // left
+            default: return x + y;   // bottom-left
+        }
+    };
+    // Directions are ordered counter-clockwise starting at the bottom.
+    std::array<Point<T>, 8> octagon;
+    octagon.fill(points.front());
+    for (const auto& point : points) {
+        for (int direction = 0; direction < 8; ++direction) {
+            if (key(point, direction) < key(octagon[direction], direction)) {
+                octagon[direction] = point;
+            }
+        }
+    }
+    std::array<Point<T>, 8> corners;
+    std::size_t count = 0;
+    for (const auto& corner : octagon) {
+        if (count == 0 || corner.x() != corners[count - 1].x() || corner.y() != corners[count - 1].y()) {
+            corners[count++] = corner;
+        }
+    }
+    while (count > 1 && corners[0].x() == corners[count - 1].x() && corners[0].y() == corners[count - 1].y()) {
+        --count;
+    }
+    if (count < 3) {
+        return;
+    }
+    std::erase_if(points, [&](const Point<T>& point) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (orientation(corners[i], corners[(i + 1) % count], point) <= 0) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+template <Scalar T>
+std::vector<Point<T>> partial_hull(const Array<std::shared_ptr<Figure<T>>>& figures, std::size_t first,
+                                   std::size_t last) {
+    std::vector<Point<T>> points;
+    for (auto i = first; i < last; ++i) {
+        if (const auto& figure = figures[i]) {
+            const auto count = figure->vertex_count();
+            for (std::size_t k = 0; k < count; ++k) {
+                points.push_back(figure->vertex(k));
+            }
+        }
+    }
+    discard_interior(points);
+    return monotone_chain(points);
+}
+
+[[nodiscard]] inline Circle circle_from(const Point<double>& a, const Point<double>& b) {
+    const Point<double> center{(a.x() + b.x()) / 2.0, (a.y() + b.y()) / 2.0};
+    return Circle{center, std::hypot(a.x() - center.x(), a.y() - center.y())};
+}
+
+[[nodiscard]] inline Circle circle_from(const Point<double>& a, const Point<double>& b, const Point<double>& c) {
+    const auto bx = b.x() - a.x();
+    const auto by = b.y() - a.y();
+    const auto cx = c.x() - a.x();
+    const auto cy = c.y() - a.y();
+    const auto d = 2.0 * (bx * cy - by * cx);
+    if (d == 0.0) {
+        // Collinear: the two farthest points span the circle.
+        const auto ab = circle_from(a, b);
+        const auto ac = circle_from(a, c);
+        const auto bc = circle_from(b, c);
+        return ab.radius >= ac.radius ? (ab.radius >= bc.radius ? ab : bc) : (ac.radius >= bc.radius ? ac : bc);
+    }
+    const auto b2 = bx * bx + by * by;
+    const auto c2 = cx * cx + cy * cy;
+    const auto ux = (cy * b2 - by * c2) / d;
+    const auto uy = (bx * c2 - cx * b2) / d;
+    return Circle{Point<double>{a.x() + ux, a.y() + uy}, std::hypot(ux, uy)};
+}
+
+}  // namespace detail
+
+// Convex hull of every vertex in the collection, counter-clockwise and
+// without collinear points; fewer than three points come back as they are.
+// Figures are read through vertex() so no per-figure vertex arrays are
+// built.
+//
+// This overload hulls slices of the collection as tasks on `pool` and merges
+// the partial hulls.
+template <Scalar T>
+std::vector<Point<T>> convex_hull(const Array<std::shared_ptr<Figure<T>>>& figures, ThreadPool& pool) {
+    const auto slices = std::max<std::size_t>(1, std::min(figures.size(), pool.size()));
+    std::vector<std::vector<Point<T>>> partial(slices);
+    pool.parallel_for(slices, 1, [&](std::size_t first, std::size_t last) {
+        for (auto slice = first; slice < last; ++slice) {
+            partial[slice] = detail::partial_hull(figures, figures.size() * slice / slices,
+                                                  figures.size() * (slice + 1) / slices);
+        }
+    });
+
+    std::vector<Point<T>> merged;
+    for (const auto& hull : partial) {
+        merged.insert(merged.end(), hull.begin(), hull.end());
+    }
+    return detail::monotone_chain(merged);
+}
+
+// Hulls on the calling thread, or with thread_count > 1 (0 means hardware
+// concurrency) on a pool of that many threads made for the call.
+template <Scalar T>
+std::vector<Point<T>> convex_hull(const Array<std::shared_ptr<Figure<T>>>& figures, std::size_t thread_count = 1) {
+    if (thread_count == 1) {
+        return detail::partial_hull(figures, 0, figures.size());
+    }
+    ThreadPool pool{thread_count};
+    return convex_hull(figures, pool);
+}
+
+// Smallest circle containing all `input` points (Welzl's algorithm in its
+// randomized incremental form, expected linear time). No points yield a
+// zero circle at the origin.
+template <Scalar T>
+Circle min_enclosing_circle(std::span<const Point<T>> input) {
+    std::vector<Point<double>> points;
+    points.reserve(input.size());
+    for (const auto& point : input) {
+        points.emplace_back(static_cast<double>(point.x()), static_cast<double>(point.y()));
+    }
+    if (points.empty()) {
+        return Circle{};
+    }
+    std::shuffle(points.begin(), points.end(), std::mt19937{0x5eed});
+
+    Circle circle{points[0], 0.0};
+    for (std::size_t i = 1; i < points.size(); ++i) {
+        if (circle.contains(points[i])) {
+            continue;
+        }
+        circle = Circle{points[i], 0.0};
+        for (std::size_t j = 0; j < i; ++j) {
+            if (circle.contains(points[j])) {
+                continue;
+            }
+            circle = detail::circle_from(points[i], points[j]);
+            for (std::size_t k = 0; k < j; ++k) {
+                if (!circle.contains(points[k])) {
+                    circle = detail::circle_from(points[i], points[j], points[k]);
+                }
+            }
+        }
+    }
+    return circle;
+}
+
+// Smallest circle containing every vertex of the collection. Only hull
+// vertices can touch it, so Welzl runs over convex_hull(figures).
+template <Scalar T>
+Circle min_enclosing_circle(const Array<std::shared_ptr<Figure<T>>>& figures, std::size_t thread_count = 1) {
+    const auto hull = convex_hull(figures, thread_count);
+    return min_enclosing_circle(std::span<const Point<T>>{hull});
+}
+
+template <Scalar T>
+Circle min_enclosing_circle(const Array<std::shared_ptr<Figure<T>>>& figures, ThreadPool& pool) {
+    const auto hull = convex_hull(figures, pool);
+    return min_enclosing_circle(std::span<const Point<T>>{hull});
+}
+
+}  // namespace lab04
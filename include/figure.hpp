@@ -1,12 +1,25 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <memory_resource>
 #include <ostream>
 
 #include "point.hpp"
 
 namespace lab04 {
 
+// Upper bound on the arena bytes one allocation of `size` bytes with the
+// given alignment can consume, padding included.
+[[nodiscard]] constexpr std::size_t arena_footprint(std::size_t size, std::size_t alignment) noexcept {
+    return size + alignment - 1;
+}
+
+template <typename U>
+[[nodiscard]] constexpr std::size_t arena_footprint(std::size_t count = 1) noexcept {
+    return arena_footprint(sizeof(U) * count, alignof(U));
+}
+
 template <Scalar T>
 class Figure {
 public:
@@ -17,6 +30,16 @@ public:
     [[nodiscard]] virtual double area() const = 0;
     virtual void print(std::ostream& os) const = 0;
     [[nodiscard]] virtual std::unique_ptr<Figure<T>> clone() const = 0;
+    [[nodiscard]] virtual std::size_t vertex_count() const = 0;
+    [[nodiscard]] virtual Point<T> vertex(std::size_t index) const = 0;
+    [[nodiscard]] virtual bool contains(const Point<T>& point) const = 0;
+
+    // Deep copy placed entirely in `resource`, including any vertex storage.
+    // The caller owns the object but must only run its destructor; the
+    // memory belongs to the resource. snapshot_footprint() bounds the bytes
+    // clone_into() takes from an Arena.
+    [[nodiscard]] virtual std::size_t snapshot_footprint() const = 0;
+    [[nodiscard]] virtual Figure* clone_into(std::pmr::memory_resource& resource) const = 0;
 
     explicit operator double() const { return area(); }
 
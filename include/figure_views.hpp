@@ -0,0 +1,98 @@
+#pragma once
+
+#include <memory>
+#include <ranges>
+#include <type_traits>
+
+#include "figure.hpp"
+
+// Lazy, allocation-free views over ranges of figure pointers (raw or smart):
+//
+//     for (const auto& square : figures | views::by_type<Square<double>>) ...
+//     for (double area : figures | views::where_area_gt(10.0) | views::areas) ...
+//
+// `areas` and `centers` are plain transforms, so over an Array they stay
+// sized random-access ranges and can be split by index between threads
+// (ThreadPool::parallel_for). The filtering views are only bidirectional.
+namespace lab04::views {
+
+namespace detail {
+
+template <typename Ptr>
+[[nodiscard]] constexpr auto* raw(const Ptr& ptr) noexcept {
+    if constexpr (std::is_pointer_v<Ptr>) {
+        return ptr;
+    } else {
+        return ptr.get();
+    }
+}
+
+template <typename Shape>
+struct IsA {
+    template <typename Ptr>
+    [[nodiscard]] bool operator()(const Ptr& ptr) const {
+        return dynamic_cast<const Shape*>(raw(ptr)) != nullptr;
+    }
+};
+
+template <typename Shape>
+struct AsShape {
+    template <typename Ptr>
+    [[nodiscard]] const Shape& operator()(const Ptr& ptr) const {
+        return static_cast<const Shape&>(*raw(ptr));
+    }
+};
+
+struct NotNull {
+    template <typename Ptr>
+    [[nodiscard]] bool operator()(const Ptr& ptr) const {
+        return raw(ptr) != nullptr;
+    }
+};
+
+struct AreaAbove {
+    double threshold;
+
+    template <typename Ptr>
+    [[nodiscard]] bool operator()(const Ptr& ptr) const {
+        const auto* figure = raw(ptr);
+        return figure != nullptr && figure->area() > threshold;
+    }
+};
+
+// Empty slots contribute zero so the view keeps one element per input.
+struct AreaOf {
+    template <typename Ptr>
+    [[nodiscard]] double operator()(const Ptr& ptr) const {
+        const auto* figure = raw(ptr);
+        return figure != nullptr ? figure->area() : 0.0;
+    }
+};
+
+// Requires non-null elements; compose with `non_null` otherwise.
+struct CenterOf {
+    template <typename Ptr>
+    [[nodiscard]] auto operator()(const Ptr& ptr) const {
+        return raw(ptr)->center();
+    }
+};
+
+}  // namespace detail
+
+inline constexpr auto non_null = std::views::filter(detail::NotNull{});
+
+// Yields `const Shape&` for every element whose dynamic type is Shape (or
+// derives from it). Null elements are skipped.
+template <typename Shape>
+inline constexpr auto by_type =
+    std::views::filter(detail::IsA<Shape>{}) | std::views::transform(detail::AsShape<Shape>{});
+
+[[nodiscard]] inline auto where_area_gt(double threshold) {
+    return std::views::filter(detail::AreaAbove{threshold});
+}
+
+inline constexpr auto areas = std::views::transform(detail::AreaOf{});
+
+inline constexpr auto centers = std::views::transform(detail::CenterOf{});
+
+}  // namespace lab04::views
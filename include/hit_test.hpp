@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "array.hpp"
+#include "figure.hpp"
+#include "predicates.hpp"
+#include "task_executor.hpp"
+
+namespace lab04 {
+
+// Figure indices hit by each query point, packed as offsets into one buffer:
+// the hits of query i are figures[offsets[i] .. offsets[i + 1]).
+struct HitTestResult {
+    std::vector<std::size_t> offsets{0};
+    std::vector<std::size_t> figures{};
+
+    [[nodiscard]] std::size_t query_count() const noexcept { return offsets.size() - 1; }
+
+    [[nodiscard]] std::span<const std::size_t> hits(std::size_t query) const {
+        if (query >= query_count()) {
+            throw std::out_of_range("query index out of range");
+        }
+        return std::span<const std::size_t>(figures).subspan(
+            offsets[query], offsets[query + 1] - offsets[query]);
+    }
+};
+
+// Acceleration structure for point-in-figure queries against a mostly
+// static collection. Figures are bucketed by bounding box into a uniform
+// grid; convex outlines are stored as normalized edge functions so the
+// containment test is a branch-free loop over contiguous coefficients.
+// push_back() and erase() mirror the same calls on the collection: a new
+// figure waits in a short list scanned by every query until about sqrt(n)
+// have gathered, an erased one is only marked, and the grid is rebuilt from
+// the stored entries once either kind of leftover grows too large.
+template <Scalar T>
+class HitTestIndex {
+public:
+    using point_type = Point<T>;
+
+    explicit HitTestIndex(const Array<std::shared_ptr<Figure<T>>>& figures) : figure_count_(figures.size()) {
+        for (std::size_t i = 0; i < figures.size(); ++i) {
+            if (figures[i]) {
+                add_entry(i, figures[i]);
+            }
+        }
+        build_grid();
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return entries_.size() - erased_; }
+
+    // Indexes a figure appended to the collection.
+    void push_back(const std::shared_ptr<Figure<T>>& figure) {
+        const auto index = figure_count_++;
+        if (!figure || !add_entry(index, figure)) {
+            return;
+        }
+        if (columns_ == 0) {
+            build_grid();
+            return;
+        }
+        pending_.push_back(entries_.size() - 1);
+        if (pending_.size() * pending_.size() > std::max<std::size_t>(entries_.size(), 256)) {
+            rebuild();
+        }
+    }
+
+    // Forgets the figure at `index`; later figures move down one index, as
+    // in Array::erase.
+    void erase(std::size_t index) {
+        if (index >= figure_count_) {
+            throw std::out_of_range("figure index out of range");
+        }
+        --figure_count_;
+        for (auto& entry : entries_) {
+            if (entry.figure_index == index) {
+                entry.figure_index = kErased;
+                ++erased_;
+            } else if (entry.figure_index > index && entry.figure_index != kErased) {
+                --entry.figure_index;
+            }
+        }
+        if (erased_ * 2 > entries_.size()) {
+            rebuild();
+        }
+    }
+
+    [[nodiscard]] std::vector<std::size_t> query(const point_type& point) const {
+        std::vector<std::size_t> result;
+        collect(point, result);
+        return result;
+    }
+
+    // Appends the hits of `point` to `out`, e.g. a SmallArray, so a caller
+    // answering one query at a time need not allocate for the usual few hits.
+    template <typename Output>
+    void query(const point_type& point, Output& out) const {
+        collect(point, out);
+    }
+
+    // Hits of every point in `points`, with chunks of the batch classified
+    // as tasks on `pool`.
+    [[nodiscard]] HitTestResult classify(std::span<const point_type> points, ThreadPool& pool) const {
+        const auto chunks = std::max<std::size_t>(1, std::min(points.size(), pool.size() * 4));
+        std::vector<HitTestResult> partial(chunks);
+        pool.parallel_for(chunks, 1, [&](std::size_t first, std::size_t last) {
+            for (auto chunk = first; chunk < last; ++chunk) {
+                partial[chunk] = classify_range(points, points.size() * chunk / chunks,
+                                                points.size() * (chunk + 1) / chunks);
+            }
+        });
+
+        HitTestResult result;
+        std::size_t total_hits = 0;
+        for (const auto& part : partial) {
+            total_hits += part.figures.size();
+        }
+        result.offsets.reserve(points.size() + 1);
+        result.figures.reserve(total_hits);
+        for (const auto& part : partial) {
+            const auto base = result.figures.size();
+            for (std::size_t i = 1; i < part.offsets.size(); ++i) {
+                result.offsets.push_back(base + part.offsets[i]);
+            }
+            result.figures.insert(result.figures.end(), part.figures.begin(), part.figures.end());
+        }
+        return result;
+    }
+
+    // Classifies on the calling thread, or with thread_count > 1 (0 means
+    // hardware concurrency) on a pool of that many threads made for the call.
+    [[nodiscard]] HitTestResult classify(std::span<const point_type> points, std::size_t thread_count = 1) const {
+        if (thread_count == 1) {
+            return classify_range(points, 0, points.size());
+        }
+        ThreadPool pool{thread_count};
+        return classify(points, pool);
+    }
+
+private:
+    static constexpr std::size_t kErased = std::numeric_limits<std::size_t>::max();
+
+    struct Entry {
+        std::size_t figure_index{};
+        double min_x{};
+        double min_y{};
+        double max_x{};
+        double max_y{};
+        std::size_t first_edge{};
+        std::size_t edge_count{};
+        double tolerance{};
+        bool convex{};
+    };
+
+    std::vector<Entry> entries_;
+    std::vector<std::shared_ptr<Figure<T>>> figures_;
+    std::vector<double> edge_a_;
+    std::vector<double> edge_b_;
+    std::vector<double> edge_c_;
+
+    double grid_min_x_{};
+    double grid_min_y_{};
+    double cell_width_{1.0};
+    double cell_height_{1.0};
+    std::size_t columns_{0};
+    std::size_t rows_{0};
+    std::vector<std::size_t> cell_offsets_;
+    std::vector<std::size_t> cell_entries_;
+
+    std::size_t figure_count_{0};
+    std::size_t erased_{0};
+    // Entries added since the grid was built, in figure order.
+    std::vector<std::size_t> pending_;
+
+    [[nodiscard]] HitTestResult classify_range(std::span<const point_type> points, std::size_t first,
+                                               std::size_t last) const {
+        HitTestResult out;
+        out.offsets.reserve(last - first + 1);
+        for (auto i = first; i < last; ++i) {
+            collect(points[i], out.figures);
+            out.offsets.push_back(out.figures.size());
+        }
+        return out;
+    }
+
+    // Appends the figure's entry; false if nothing can ever hit it.
+    bool add_entry(std::size_t index, const std::shared_ptr<Figure<T>>& figure) {
+        const auto count = figure->vertex_count();
+        if (count == 0) {
+            return false;
+        }
+
+        std::vector<Point<double>> points(count);
+        std::vector<double> xs(count);
+        std::vector<double> ys(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto vertex = figure->vertex(i);
+            xs[i] = static_cast<double>(vertex.x());
+            ys[i] = static_cast<double>(vertex.y());
+            points[i] = Point<double>{xs[i], ys[i]};
+        }
+
+        Entry entry;
+        entry.figure_index = index;
+        entry.min_x = *std::min_element(xs.begin(), xs.end());
+        entry.max_x = *std::max_element(xs.begin(), xs.end());
+        entry.min_y = *std::min_element(ys.begin(), ys.end());
+        entry.max_y = *std::max_element(ys.begin(), ys.end());
+        // Nothing can hit an outline with infinite or NaN coordinates.
+        if (!std::isfinite(entry.max_x - entry.min_x) || !std::isfinite(entry.max_y - entry.min_y)) {
+            return false;
+        }
+        const auto magnitude = std::max({1.0, std::fabs(entry.min_x), std::fabs(entry.max_x),
+                                         std::fabs(entry.min_y), std::fabs(entry.max_y)});
+        entry.tolerance = std::numeric_limits<double>::epsilon() * 16 * magnitude;
+
+        // Self-intersecting outlines fall back to the figure's even-odd test.
+        const auto orientation = convex_orientation(points);
+        entry.convex = orientation != 0;
+
+        if (entry.convex) {
+            entry.first_edge = edge_a_.size();
+            entry.edge_count = count;
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto j = (i + 1) % count;
+                auto a = -(ys[j] - ys[i]) * orientation;
+                auto b = (xs[j] - xs[i]) * orientation;
+                const auto length = std::hypot(a, b);
+                if (length > 0.0) {
+                    a /= length;
+                    b /= length;
+                }
+                edge_a_.push_back(a);
+                edge_b_.push_back(b);
+                edge_c_.push_back(-(a * xs[i] + b * ys[i]));
+            }
+        }
+
+        entries_.push_back(entry);
+        figures_.push_back(figure);
+        return true;
+    }
+
+    // Drops erased entries and their edges, then grids everything anew.
+    void rebuild() {
+        std::vector<Entry> entries;
+        std::vector<std::shared_ptr<Figure<T>>> figures;
+        std::vector<double> edge_a;
+        std::vector<double> edge_b;
+        std::vector<double> edge_c;
+        entries.reserve(size());
+        figures.reserve(size());
+        for (std::size_t e = 0; e < entries_.size(); ++e) {
+            auto entry = entries_[e];
+            if (entry.figure_index == kErased) {
+                continue;
+            }
+            const auto first = entry.first_edge;
+            entry.first_edge = edge_a.size();
+            for (auto i = first; i < first + entry.edge_count; ++i) {
+                edge_a.push_back(edge_a_[i]);
+                edge_b.push_back(edge_b_[i]);
+                edge_c.push_back(edge_c_[i]);
+            }
+            entries.push_back(entry);
+            figures.push_back(std::move(figures_[e]));
+        }
+        entries_ = std::move(entries);
+        figures_ = std::move(figures);
+        edge_a_ = std::move(edge_a);
+        edge_b_ = std::move(edge_b);
+        edge_c_ = std::move(edge_c);
+        erased_ = 0;
+        pending_.clear();
+        columns_ = 0;
+        rows_ = 0;
+        cell_offsets_.clear();
+        cell_entries_.clear();
+        build_grid();
+    }
+
+    void build_grid() {
+        if (entries_.empty()) {
+            return;
+        }
+        auto max_x = entries_.front().max_x;
+        auto max_y = entries_.front().max_y;
+        grid_min_x_ = entries_.front().min_x;
+        grid_min_y_ = entries_.front().min_y;
+        for (const auto& entry : entries_) {
+            grid_min_x_ = std::min(grid_min_x_, entry.min_x);
+            grid_min_y_ = std::min(grid_min_y_, entry.min_y);
+            max_x = std::max(max_x, entry.max_x);
+            max_y = std::max(max_y, entry.max_y);
+        }
+
+        const auto side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(entries_.size()))));
+        columns_ = std::clamp<std::size_t>(side, 1, 1024);
+        rows_ = columns_;
+        cell_width_ = std::max((max_x - grid_min_x_) / static_cast<double>(columns_),
+                               std::numeric_limits<double>::min());
+        cell_height_ = std::max((max_y - grid_min_y_) / static_cast<double>(rows_),
+                                std::numeric_limits<double>::min());
+
+        cell_offsets_.assign(columns_ * rows_ + 1, 0);
+        for (const auto& entry : entries_) {
+            for_each_cell(entry, [&](std::size_t cell) { ++cell_offsets_[cell + 1]; });
+        }
+        for (std::size_t i = 1; i < cell_offsets_.size(); ++i) {
+            cell_offsets_[i] += cell_offsets_[i - 1];
+        }
+        cell_entries_.resize(cell_offsets_.back());
+        auto cursor = cell_offsets_;
+        for (std::size_t e = 0; e < entries_.size(); ++e) {
+            for_each_cell(entries_[e], [&](std::size_t cell) { cell_entries_[cursor[cell]++] = e; });
+        }
+    }
+
+    // Cell coordinate of `value` along one axis; the negated comparison also
+    // maps NaN to the first cell, since casting NaN to an integer is undefined.
+    [[nodiscard]] static std::size_t cell_of(double value, double origin, double cell_size, std::size_t cells) {
+        const auto cell = std::floor((value - origin) / cell_size);
+        if (!(cell > 0.0)) {
+            return 0;
+        }
+        return static_cast<std::size_t>(std::min(cell, static_cast<double>(cells - 1)));
+    }
+
+    [[nodiscard]] std::size_t column_of(double x) const { return cell_of(x, grid_min_x_, cell_width_, columns_); }
+
+    [[nodiscard]] std::size_t row_of(double y) const { return cell_of(y, grid_min_y_, cell_height_, rows_); }
+
+    template <typename Fn>
+    void for_each_cell(const Entry& entry, Fn&& fn) const {
+        const auto first_column = column_of(entry.min_x);
+        const auto last_column = column_of(entry.max_x);
+        const auto first_row = row_of(entry.min_y);
+        const auto last_row = row_of(entry.max_y);
+        for (auto row = first_row; row <= last_row; ++row) {
+            for (auto column = first_column; column <= last_column; ++column) {
+                fn(row * columns_ + column);
+            }
+        }
+    }
+
+    [[nodiscard]] bool entry_contains(std::size_t e, double x, double y, const point_type& point) const {
+        const auto& entry = entries_[e];
+        if (x < entry.min_x - entry.tolerance || x > entry.max_x + entry.tolerance ||
+            y < entry.min_y - entry.tolerance || y > entry.max_y + entry.tolerance) {
+            return false;
+        }
+        if (!entry.convex) {
+            return figures_[e]->contains(point);
+        }
+        const auto* a = edge_a_.data() + entry.first_edge;
+        const auto* b = edge_b_.data() + entry.first_edge;
+        const auto* c = edge_c_.data() + entry.first_edge;
+        const auto limit = -entry.tolerance;
+        unsigned inside = 1;
+        for (std::size_t i = 0; i < entry.edge_count; ++i) {
+            inside &= static_cast<unsigned>(a[i] * x + b[i] * y + c[i] >= limit);
+        }
+        return inside != 0;
+    }
+
+    template <typename Output>
+    void collect(const point_type& point, Output& out) const {
+        if (entries_.empty()) {
+            return;
+        }
+        const auto x = static_cast<double>(point.x());
+        const auto y = static_cast<double>(point.y());
+        if (!std::isfinite(x) || !std::isfinite(y)) {
+            return;
+        }
+        const auto cell = row_of(y) * columns_ + column_of(x);
+        for (auto i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+            const auto e = cell_entries_[i];
+            if (entries_[e].figure_index != kErased && entry_contains(e, x, y, point)) {
+                out.push_back(entries_[e].figure_index);
+            }
+        }
+        for (const auto e : pending_) {
+            if (entries_[e].figure_index != kErased && entry_contains(e, x, y, point)) {
+                out.push_back(entries_[e].figure_index);
+            }
+        }
+    }
+};
+
+}  // namespace lab04
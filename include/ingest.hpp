@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "array.hpp"
+#include "figure.hpp"
+#include "rectangle.hpp"
+#include "square.hpp"
+#include "triangle.hpp"
+
+namespace lab04 {
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// push() waits while the queue is full, which throttles a fast producer to
+// the pace of its consumer. Either side may close() the queue: the consumer
+// still drains what was pushed, and a producer waiting on a full queue gives
+// up.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots_ = std::make_unique<std::optional<T>[]>(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    bool try_push(T& value) {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[tail & mask_].emplace(std::move(value));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false, dropping `value`, once the queue is closed.
+    bool push(T value) {
+        while (!try_push(value)) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    bool try_pop(T& value) {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        auto& slot = slots_[head & mask_];
+        value = std::move(*slot);
+        slot.reset();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Waits for the next value; returns false once the queue is closed and drained.
+    bool pop(T& value) {
+        while (!try_pop(value)) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return try_pop(value);
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    void close() noexcept { closed_.store(true, std::memory_order_release); }
+
+private:
+    std::unique_ptr<std::optional<T>[]> slots_;
+    std::size_t mask_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::atomic<bool> closed_{false};
+};
+
+enum class FigureKind { Triangle, Square, Rectangle };
+
+// One parsed input line. Triangles come either as "triangle cx cy base height"
+// or by vertices as "triangle ax ay lx ly rx ry".
+template <Scalar T>
+struct FigureSpec {
+    FigureKind kind{FigureKind::Square};
+    std::size_t line{0};
+    std::size_t value_count{0};
+    T values[6]{};
+};
+
+struct IngestError {
+    std::size_t line{0};
+    std::string message;
+};
+
+struct IngestOptions {
+    std::size_t batch_size{256};
+    std::size_t queue_capacity{8};
+};
+
+struct IngestReport {
+    std::size_t accepted{0};
+    std::vector<IngestError> errors;
+};
+
+namespace detail {
+
+template <Scalar T>
+bool parse_figure_line(const std::string& text, std::size_t line, FigureSpec<T>& spec, std::string& error) {
+    std::istringstream in{text};
+    std::string name;
+    in >> name;
+    spec.line = line;
+    if (name == "triangle") {
+        spec.kind = FigureKind::Triangle;
+    } else if (name == "square") {
+        spec.kind = FigureKind::Square;
+    } else if (name == "rectangle") {
+        spec.kind = FigureKind::Rectangle;
+    } else {
+        error = "unknown figure '" + name + "'";
+        return false;
+    }
+
+    spec.value_count = 0;
+    T value{};
+    while (spec.value_count < 6 && in >> value) {
+        spec.values[spec.value_count++] = value;
+    }
+    if (!in.eof()) {
+        in.clear();
+        std::string rest;
+        if (in >> rest) {
+            error = "unexpected token '" + rest + "'";
+            return false;
+        }
+    }
+
+    const bool valid = (spec.kind == FigureKind::Triangle && (spec.value_count == 4 || spec.value_count == 6)) ||
+                       (spec.kind == FigureKind::Square && spec.value_count == 3) ||
+                       (spec.kind == FigureKind::Rectangle && spec.value_count == 4);
+    if (!valid) {
+        error = "wrong number of parameters for " + name;
+        return false;
+    }
+    return true;
+}
+
+template <Scalar T>
+std::shared_ptr<Figure<T>> construct_figure(const FigureSpec<T>& spec) {
+    const auto* v = spec.values;
+    switch (spec.kind) {
+        case FigureKind::Triangle:
+            if (spec.value_count == 6) {
+                return std::make_shared<Triangle<T>>(Point<T>(v[0], v[1]), Point<T>(v[2], v[3]),
+                                                     Point<T>(v[4], v[5]));
+            }
+            return std::make_shared<Triangle<T>>(Point<T>(v[0], v[1]), v[2], v[3]);
+        case FigureKind::Square:
+            return std::make_shared<Square<T>>(Point<T>(v[0], v[1]), v[2]);
+        case FigureKind::Rectangle:
+            return std::make_shared<Rectangle<T>>(Point<T>(v[0], v[1]), v[2], v[3]);
+    }
+    throw std::invalid_argument("unknown figure kind");
+}
+
+}  // namespace detail
+
+// Reads one figure per line and appends the valid ones to `figures` in input
+// order. Parsing, validation/construction and insertion run as three stages
+// on separate threads connected by bounded queues of record batches; blank
+// lines and lines starting with '#' are skipped. An exception in any stage,
+// including one thrown by the stream, stops the others and is rethrown here;
+// the figures inserted before it stay in the collection.
+template <Scalar T, typename Growth>
+IngestReport ingest_figures(std::istream& in, Array<std::shared_ptr<Figure<T>>, Growth>& figures,
+                            IngestOptions options = {}) {
+    struct ParsedBatch {
+        std::vector<FigureSpec<T>> specs;
+        std::vector<IngestError> errors;
+    };
+    struct BuiltBatch {
+        std::vector<std::shared_ptr<Figure<T>>> figures;
+        std::vector<IngestError> errors;
+    };
+
+    const auto batch_size = std::max<std::size_t>(1, options.batch_size);
+    SpscQueue<ParsedBatch> parsed{options.queue_capacity};
+    SpscQueue<BuiltBatch> built{options.queue_capacity};
+    std::exception_ptr parser_error;
+    std::exception_ptr builder_error;
+
+    std::jthread parser([&](std::stop_token stop) {
+        try {
+            ParsedBatch batch;
+            std::string text;
+            std::size_t line = 0;
+            while (!stop.stop_requested() && std::getline(in, text)) {
+                ++line;
+                const auto first = text.find_first_not_of(" \t\r");
+                if (first == std::string::npos || text[first] == '#') {
+                    continue;
+                }
+                FigureSpec<T> spec;
+                std::string error;
+                if (detail::parse_figure_line(text, line, spec, error)) {
+                    batch.specs.push_back(spec);
+                } else {
+                    batch.errors.push_back(IngestError{line, std::move(error)});
+                }
+                if (batch.specs.size() + batch.errors.size() >= batch_size &&
+                    !parsed.push(std::exchange(batch, ParsedBatch{}))) {
+                    break;
+                }
+            }
+            parsed.push(std::move(batch));
+        } catch (...) {
+            parser_error = std::current_exception();
+        }
+        parsed.close();
+    });
+
+    std::jthread builder([&](std::stop_token stop) {
+        try {
+            ParsedBatch input;
+            while (!stop.stop_requested() && parsed.pop(input)) {
+                BuiltBatch output;
+                output.figures.reserve(input.specs.size());
+                output.errors = std::move(input.errors);
+                for (const auto& spec : input.specs) {
+                    try {
+                        output.figures.push_back(detail::construct_figure(spec));
+                    } catch (const std::invalid_argument& ex) {
+                        output.errors.push_back(IngestError{spec.line, ex.what()});
+                    }
+                }
+                if (!built.push(std::move(output))) {
+                    break;
+                }
+            }
+        } catch (...) {
+            builder_error = std::current_exception();
+        }
+        // Closing the input as well releases a parser blocked on a full queue.
+        parsed.close();
+        built.close();
+    });
+
+    // Every exit, the exceptional ones included, releases both stages before
+    // the jthreads request stop and join.
+    struct CloseQueues {
+        SpscQueue<ParsedBatch>& parsed;
+        SpscQueue<BuiltBatch>& built;
+
+        ~CloseQueues() {
+            parsed.close();
+            built.close();
+        }
+    } close_queues{parsed, built};
+
+    IngestReport report;
+    BuiltBatch batch;
+    while (built.pop(batch)) {
+        for (auto& figure : batch.figures) {
+            figures.push_back(std::move(figure));
+        }
+        report.accepted += batch.figures.size();
+        for (auto& error : batch.errors) {
+            report.errors.push_back(std::move(error));
+        }
+    }
+    builder.join();
+    parser.join();
+    if (parser_error) {
+        std::rethrow_exception(parser_error);
+    }
+    if (builder_error) {
+        std::rethrow_exception(builder_error);
+    }
+    std::sort(report.errors.begin(), report.errors.end(),
+              [](const IngestError& lhs, const IngestError& rhs) { return lhs.line < rhs.line; });
+    return report;
+}
+
+}  // namespace lab04
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lab04 {
+
+#if defined(LAB04_ENABLE_INSTRUMENTATION)
+inline constexpr bool kInstrumentationEnabled = true;
+#else
+inline constexpr bool kInstrumentationEnabled = false;
+#endif
+
+// Latency histogram with log-linear buckets (HDR style): values below 64 ns
+// are exact, above that every power of two is split into 32 linear
+// sub-buckets, so any recorded value is off by at most ~3%. Recording is a
+// handful of relaxed atomic increments and is safe from any thread.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+    static constexpr std::size_t kBucketCount = (65 - kSubBucketBits) * kSubBuckets;
+
+    explicit LatencyHistogram(std::string name = {}) : name_(std::move(name)) {}
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    [[nodiscard]] const std::string& name() const noexcept { return name_; }
+
+    [[nodiscard]] static constexpr std::size_t bucket_of(std::uint64_t value) noexcept {
+        if (value < 2 * kSubBuckets) {
+            return static_cast<std::size_t>(value);
+        }
+        const auto shift = static_cast<unsigned>(std::bit_width(value)) - (kSubBucketBits + 1);
+        return (shift + 1) * kSubBuckets + static_cast<std::size_t>(value >> shift) - kSubBuckets;
+    }
+
+    // Largest value that falls into `bucket`.
+    [[nodiscard]] static constexpr std::uint64_t bucket_upper(std::size_t bucket) noexcept {
+        if (bucket < 2 * kSubBuckets) {
+            return bucket;
+        }
+        const auto shift = static_cast<unsigned>(bucket / kSubBuckets - 1);
+        const auto sub = static_cast<std::uint64_t>(bucket % kSubBuckets + kSubBuckets);
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void record(std::uint64_t nanoseconds) noexcept {
+        buckets_[bucket_of(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+        auto current = max_.load(std::memory_order_relaxed);
+        while (nanoseconds > current && !max_.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+        }
+        current = min_.load(std::memory_order_relaxed);
+        while (nanoseconds < current && !min_.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return count_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::uint64_t max() const noexcept { return max_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::uint64_t min() const noexcept {
+        return count() == 0 ? 0 : min_.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] double mean() const noexcept {
+        const auto n = count();
+        return n == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(n);
+    }
+
+    // Smallest bucket bound below which at least `quantile` of the samples
+    // fall, clamped to the recorded maximum.
+    [[nodiscard]] std::uint64_t percentile(double quantile) const noexcept {
+        const auto total = count();
+        if (total == 0) {
+            return 0;
+        }
+        const auto rank = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(total) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(bucket_upper(i), max());
+            }
+        }
+        return max();
+    }
+
+    void reset() noexcept {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+        min_.store(UINT64_MAX, std::memory_order_relaxed);
+    }
+
+private:
+    std::string name_;
+    std::array<std::atomic<std::uint64_t>, kBucketCount> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+    std::atomic<std::uint64_t> min_{UINT64_MAX};
+};
+
+struct TraceEvent {
+    const LatencyHistogram* histogram{nullptr};
+    std::uint64_t start_ns{0};
+    std::uint64_t duration_ns{0};
+    std::uint32_t thread{0};
+};
+
+// Process-wide registry of named histograms plus an optional bounded buffer
+// of complete ("ph":"X") trace events in the Chrome trace-event format,
+// which chrome://tracing and Perfetto can open directly.
+class Instrumentation {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static Instrumentation& instance() {
+        static Instrumentation registry;
+        return registry;
+    }
+
+    // The returned reference stays valid for the life of the process.
+    LatencyHistogram& histogram(std::string_view name) {
+        const std::lock_guard lock{mutex_};
+        auto it = histograms_.find(name);
+        if (it == histograms_.end()) {
+            it = histograms_.emplace(std::string{name}, std::make_unique<LatencyHistogram>(std::string{name})).first;
+        }
+        return *it->second;
+    }
+
+    void enable_trace(bool enabled, std::size_t max_events = 1 << 20) {
+        const std::lock_guard lock{mutex_};
+        max_events_ = max_events;
+        tracing_.store(enabled, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool tracing() const noexcept { return tracing_.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] std::uint64_t since_start(clock::time_point time) const noexcept {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch_).count());
+    }
+
+    void add_trace_event(const TraceEvent& event) {
+        const std::lock_guard lock{mutex_};
+        if (events_.size() < max_events_) {
+            events_.push_back(event);
+        } else {
+            ++dropped_events_;
+        }
+    }
+
+    void reset() {
+        const std::lock_guard lock{mutex_};
+        for (auto& [name, histogram] : histograms_) {
+            histogram->reset();
+        }
+        events_.clear();
+        dropped_events_ = 0;
+    }
+
+    void dump_text(std::ostream& os) const {
+        const std::lock_guard lock{mutex_};
+        const auto previous_flags = os.flags();
+        os << std::left << std::setw(24) << "operation" << std::right;
+        for (const char* column : {"count", "min", "p50", "p99", "p999", "max", "mean"}) {
+            os << std::setw(12) << column;
+        }
+        os << "  (ns)\n";
+        for (const auto& [name, histogram] : histograms_) {
+            if (histogram->count() == 0) {
+                continue;
+            }
+            os << std::left << std::setw(24) << name << std::right << std::setw(12) << histogram->count()
+               << std::setw(12) << histogram->min() << std::setw(12) << histogram->percentile(0.5)
+               << std::setw(12) << histogram->percentile(0.99) << std::setw(12) << histogram->percentile(0.999)
+               << std::setw(12) << histogram->max() << std::setw(12) << static_cast<std::uint64_t>(histogram->mean())
+               << '\n';
+        }
+        os.flags(previous_flags);
+    }
+
+    void dump_json(std::ostream& os) const {
+        const std::lock_guard lock{mutex_};
+        os << '{';
+        bool first = true;
+        for (const auto& [name, histogram] : histograms_) {
+            if (histogram->count() == 0) {
+                continue;
+            }
+            os << (first ? "" : ",") << "\n  ";
+            first = false;
+            write_json_string(os, name);
+            os << ": {\"count\": " << histogram->count() << ", \"min_ns\": " << histogram->min()
+               << ", \"p50_ns\": " << histogram->percentile(0.5) << ", \"p90_ns\": " << histogram->percentile(0.9)
+               << ", \"p99_ns\": " << histogram->percentile(0.99)
+               << ", \"p999_ns\": " << histogram->percentile(0.999) << ", \"max_ns\": " << histogram->max()
+               << ", \"mean_ns\": " << static_cast<std::uint64_t>(histogram->mean()) << '}';
+        }
+        os << (first ? "}\n" : "\n}\n");
+    }
+
+    void write_trace(std::ostream& os) const {
+        const std::lock_guard lock{mutex_};
+        os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+        for (std::size_t i = 0; i < events_.size(); ++i) {
+            const auto& event = events_[i];
+            os << (i == 0 ? "" : ",") << "\n  {\"name\": ";
+            write_json_string(os, event.histogram->name());
+            os << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread << ", \"ts\": " << event.start_ns / 1000
+               << '.' << std::setw(3) << std::setfill('0') << event.start_ns % 1000 << std::setfill(' ')
+               << ", \"dur\": " << event.duration_ns / 1000 << '.' << std::setw(3) << std::setfill('0')
+               << event.duration_ns % 1000 << std::setfill(' ') << '}';
+        }
+        os << "\n], \"otherData\": {\"dropped_events\": " << dropped_events_ << "}}\n";
+    }
+
+    [[nodiscard]] static std::uint32_t thread_index() noexcept {
+        static std::atomic<std::uint32_t> next{1};
+        thread_local const std::uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+private:
+    Instrumentation() = default;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>, std::less<>> histograms_;
+    std::vector<TraceEvent> events_;
+    std::size_t max_events_{0};
+    std::size_t dropped_events_{0};
+    std::atomic<bool> tracing_{false};
+    const clock::time_point epoch_{clock::now()};
+
+    static void write_json_string(std::ostream& os, std::string_view text) {
+        os << '"';
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                os << '\\' << c;
+            } else if (static_cast<unsigned char>(c) >= 0x20) {
+                os << c;
+            }
+        }
+        os << '"';
+    }
+};
+
+// Records the lifetime of the enclosing scope into `histogram` and, while
+// tracing is on, as a trace event.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram& histogram) noexcept
+        : histogram_(histogram), start_(Instrumentation::clock::now()) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        const auto end = Instrumentation::clock::now();
+        const auto elapsed =
+            static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count());
+        histogram_.record(elapsed);
+        auto& registry = Instrumentation::instance();
+        if (registry.tracing()) {
+            try {
+                registry.add_trace_event(
+                    TraceEvent{&histogram_, registry.since_start(start_), elapsed, Instrumentation::thread_index()});
+            } catch (...) {
+            }
+        }
+    }
+
+private:
+    LatencyHistogram& histogram_;
+    Instrumentation::clock::time_point start_;
+};
+
+}  // namespace lab04
+
+#define LAB04_INSTRUMENTATION_CONCAT_IMPL(a, b) a##b
+#define LAB04_INSTRUMENTATION_CONCAT(a, b) LAB04_INSTRUMENTATION_CONCAT_IMPL(a, b)
+
+// LAB04_TRACE_SCOPE("name") times the rest of the enclosing scope; the name
+// must be a constant, its histogram is looked up once per call site.
+// LAB04_TRACE_SCOPE_NAMED(expr) looks the name up on every call. Both expand
+// to nothing unless LAB04_ENABLE_INSTRUMENTATION is defined.
+#if defined(LAB04_ENABLE_INSTRUMENTATION)
+#define LAB04_TRACE_SCOPE(name)                                                                          \
+    static ::lab04::LatencyHistogram& LAB04_INSTRUMENTATION_CONCAT(lab04_histogram_, __LINE__) =       \
+        ::lab04::Instrumentation::instance().histogram(name);                                            \
+    const ::lab04::ScopedTimer LAB04_INSTRUMENTATION_CONCAT(lab04_timer_, __LINE__) {                    \
+        LAB04_INSTRUMENTATION_CONCAT(lab04_histogram_, __LINE__)                                         \
+    }
+#define LAB04_TRACE_SCOPE_NAMED(name)                                                 \
+    const ::lab04::ScopedTimer LAB04_INSTRUMENTATION_CONCAT(lab04_timer_, __LINE__) { \
+        ::lab04::Instrumentation::instance().histogram(name)                          \
+    }
+#else
+#define LAB04_TRACE_SCOPE(name) static_cast<void>(0)
+#define LAB04_TRACE_SCOPE_NAMED(name) static_cast<void>(0)
+#endif
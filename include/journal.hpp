@@ -0,0 +1,560 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "array.hpp"
+#include "figure.hpp"
+#include "rectangle.hpp"
+#include "runtime_polygon.hpp"
+#include "square.hpp"
+#include "triangle.hpp"
+
+namespace lab04 {
+
+struct JournalOptions {
+    std::size_t group_commit_records{1024};
+    std::size_t snapshot_every{65536};
+    // How long commit_if_due() lets the oldest buffered record wait.
+    std::chrono::milliseconds commit_delay{100};
+};
+
+namespace detail {
+
+enum class ShapeCode : std::uint8_t { Empty = 0, Triangle = 1, Square = 2, Rectangle = 3, Polygon = 4 };
+enum class JournalOp : std::uint8_t { Add = 1, Erase = 2 };
+
+inline constexpr char kJournalMagic[8] = {'L', '4', 'J', 'R', 'N', 'L', '0', '1'};
+inline constexpr char kSnapshotMagic[8] = {'L', '4', 'S', 'N', 'A', 'P', '0', '1'};
+inline constexpr std::size_t kFileHeaderSize = sizeof(kJournalMagic) + sizeof(std::uint64_t);
+inline constexpr std::size_t kRecordHeaderSize = 2 * sizeof(std::uint32_t);
+
+inline std::uint32_t fnv1a(const char* data, std::size_t size) {
+    std::uint32_t hash = 2166136261U;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+template <typename U>
+void put(std::vector<char>& out, U value) {
+    const auto offset = out.size();
+    out.resize(offset + sizeof(U));
+    std::memcpy(out.data() + offset, &value, sizeof(U));
+}
+
+template <typename U>
+bool get(const char*& cursor, const char* end, U& value) {
+    if (static_cast<std::size_t>(end - cursor) < sizeof(U)) {
+        return false;
+    }
+    std::memcpy(&value, cursor, sizeof(U));
+    cursor += sizeof(U);
+    return true;
+}
+
+[[noreturn]] inline void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+inline void write_all(int fd, const char* data, std::size_t size, const std::string& what) {
+    while (size > 0) {
+        const auto written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno(what);
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+inline std::vector<char> read_file(const std::filesystem::path& path) {
+    std::vector<char> content;
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return content;
+        }
+        throw_errno("cannot open " + path.string());
+    }
+    char buffer[1 << 16];
+    while (true) {
+        const auto count = ::read(fd, buffer, sizeof(buffer));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const int saved = errno;
+            ::close(fd);
+            errno = saved;
+            throw_errno("cannot read " + path.string());
+        }
+        if (count == 0) {
+            break;
+        }
+        content.insert(content.end(), buffer, buffer + count);
+    }
+    ::close(fd);
+    return content;
+}
+
+inline void sync_directory(const std::filesystem::path& directory) {
+    const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+// Fills the [length][checksum] header reserved at `record_offset` for the
+// payload that follows it up to the end of `out`.
+inline void seal_record(std::vector<char>& out, std::size_t record_offset) {
+    const auto payload_offset = record_offset + kRecordHeaderSize;
+    const auto length = static_cast<std::uint32_t>(out.size() - payload_offset);
+    const auto checksum = fnv1a(out.data() + payload_offset, length);
+    std::memcpy(out.data() + record_offset, &length, sizeof(length));
+    std::memcpy(out.data() + record_offset + sizeof(length), &checksum, sizeof(checksum));
+}
+
+template <Scalar T>
+ShapeCode shape_code(const Figure<T>* figure) {
+    if (figure == nullptr) {
+        return ShapeCode::Empty;
+    }
+    if (dynamic_cast<const Triangle<T>*>(figure)) {
+        return ShapeCode::Triangle;
+    }
+    if (dynamic_cast<const Square<T>*>(figure)) {
+        return ShapeCode::Square;
+    }
+    if (dynamic_cast<const Rectangle<T>*>(figure)) {
+        return ShapeCode::Rectangle;
+    }
+    if (dynamic_cast<const Polygon<T>*>(figure)) {
+        return ShapeCode::Polygon;
+    }
+    throw std::invalid_argument("figure type cannot be serialized");
+}
+
+// Rebuilds a figure from its shape code and vertices. Returns false if the
+// vertex count does not fit the shape; constructors may still throw on
+// degenerate input.
+template <Scalar T>
+bool make_figure(ShapeCode code, std::vector<Point<T>> points, std::shared_ptr<Figure<T>>& figure) {
+    const auto count = points.size();
+    switch (code) {
+        case ShapeCode::Empty:
+            figure = nullptr;
+            return count == 0;
+        case ShapeCode::Triangle:
+            if (count != 3) {
+                return false;
+            }
+            figure = std::make_shared<Triangle<T>>(points[0], points[1], points[2]);
+            return true;
+        case ShapeCode::Square:
+            if (count != 4) {
+                return false;
+            }
+            figure = std::make_shared<Square<T>>(
+                Square<T>::from_vertices({points[0], points[1], points[2], points[3]}));
+            return true;
+        case ShapeCode::Rectangle:
+            if (count != 4) {
+                return false;
+            }
+            figure = std::make_shared<Rectangle<T>>(
+                Rectangle<T>::from_vertices({points[0], points[1], points[2], points[3]}));
+            return true;
+        case ShapeCode::Polygon:
+            figure = std::make_shared<Polygon<T>>(std::move(points));
+            return true;
+    }
+    return false;
+}
+
+template <Scalar T>
+void encode_figure(std::vector<char>& out, const Figure<T>* figure) {
+    put(out, static_cast<std::uint8_t>(shape_code(figure)));
+    const auto count = figure ? figure->vertex_count() : 0;
+    put(out, static_cast<std::uint32_t>(count));
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto vertex = figure->vertex(i);
+        put(out, vertex.x());
+        put(out, vertex.y());
+    }
+}
+
+template <Scalar T>
+bool decode_figure(const char*& cursor, const char* end, std::shared_ptr<Figure<T>>& figure) {
+    std::uint8_t code = 0;
+    std::uint32_t count = 0;
+    if (!get(cursor, end, code) || !get(cursor, end, count) ||
+        static_cast<std::size_t>(end - cursor) < std::size_t{count} * 2 * sizeof(T)) {
+        return false;
+    }
+    std::vector<Point<T>> points(count);
+    for (auto& point : points) {
+        T x{};
+        T y{};
+        get(cursor, end, x);
+        get(cursor, end, y);
+        point = Point<T>(x, y);
+    }
+
+    return make_figure(static_cast<ShapeCode>(code), std::move(points), figure);
+}
+
+}  // namespace detail
+
+// Durable log of add/erase operations on a figure collection stored in a
+// directory as `snapshot.bin` plus `journal.log`. Records are checksummed and
+// buffered; commit() writes the buffer and issues one fsync for the whole
+// group, which happens by itself once group_commit_records are buffered, and
+// commit_if_due() also once the oldest of them waited commit_delay.
+// snapshot() persists the full collection and truncates the log, and
+// recover() loads the latest snapshot and replays the log tail, stopping at
+// the first torn record; a record with a valid checksum that cannot be
+// applied is corruption and throws std::runtime_error, leaving the files
+// untouched. recover() must be called once before recording. Members may be
+// called from several threads, e.g. a timer thread calling commit_if_due().
+// Files use the host byte order.
+template <Scalar T>
+class FigureJournal {
+public:
+    using collection_type = Array<std::shared_ptr<Figure<T>>>;
+
+    explicit FigureJournal(std::filesystem::path directory, JournalOptions options = {})
+        : directory_(std::move(directory)), options_(options) {
+        std::filesystem::create_directories(directory_);
+    }
+
+    FigureJournal(const FigureJournal&) = delete;
+    FigureJournal& operator=(const FigureJournal&) = delete;
+
+    ~FigureJournal() {
+        try {
+            std::lock_guard lock{mutex_};
+            commit_locked();
+        } catch (...) {
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    [[nodiscard]] const std::filesystem::path& directory() const noexcept { return directory_; }
+    [[nodiscard]] std::size_t pending_records() const {
+        std::lock_guard lock{mutex_};
+        return pending_records_;
+    }
+    [[nodiscard]] bool snapshot_due() const {
+        std::lock_guard lock{mutex_};
+        return records_since_snapshot_ >= options_.snapshot_every;
+    }
+    [[nodiscard]] std::chrono::milliseconds commit_delay() const noexcept { return options_.commit_delay; }
+
+    // Replaces the contents of `figures` with the persisted state and returns
+    // the number of log records replayed on top of the snapshot.
+    std::size_t recover(collection_type& figures) {
+        std::lock_guard lock{mutex_};
+        figures.clear();
+        generation_ = 0;
+
+        const auto snapshot = detail::read_file(snapshot_path());
+        if (!snapshot.empty()) {
+            load_snapshot(snapshot, figures);
+        }
+
+        const auto log = detail::read_file(log_path());
+        std::size_t replayed = 0;
+        std::size_t valid_size = 0;
+        if (log.size() >= detail::kFileHeaderSize &&
+            std::memcmp(log.data(), detail::kJournalMagic, sizeof(detail::kJournalMagic)) == 0) {
+            std::uint64_t generation = 0;
+            std::memcpy(&generation, log.data() + sizeof(detail::kJournalMagic), sizeof(generation));
+            if (generation == generation_) {
+                valid_size = detail::kFileHeaderSize;
+                const char* cursor = log.data() + valid_size;
+                const char* end = log.data() + log.size();
+                while (replay_record(cursor, end, figures, replayed)) {
+                    valid_size = static_cast<std::size_t>(cursor - log.data());
+                    ++replayed;
+                }
+            }
+        }
+
+        open_log(valid_size);
+        records_since_snapshot_ = replayed;
+        return replayed;
+    }
+
+    void record_add(const Figure<T>& figure) {
+        std::lock_guard lock{mutex_};
+        const auto offset = begin_record();
+        detail::put(buffer_, static_cast<std::uint8_t>(detail::JournalOp::Add));
+        detail::encode_figure(buffer_, &figure);
+        end_record(offset);
+    }
+
+    void record_erase(std::size_t index) {
+        std::lock_guard lock{mutex_};
+        const auto offset = begin_record();
+        detail::put(buffer_, static_cast<std::uint8_t>(detail::JournalOp::Erase));
+        detail::put(buffer_, static_cast<std::uint64_t>(index));
+        end_record(offset);
+    }
+
+    void commit() {
+        std::lock_guard lock{mutex_};
+        commit_locked();
+    }
+
+    // Commits if the oldest buffered record has waited commit_delay; returns
+    // whether it did.
+    bool commit_if_due() {
+        std::lock_guard lock{mutex_};
+        if (pending_records_ == 0 || std::chrono::steady_clock::now() - first_pending_ < options_.commit_delay) {
+            return false;
+        }
+        commit_locked();
+        return true;
+    }
+
+    // Writes the whole collection to a new snapshot and starts an empty log
+    // of the next generation, so a crash at any point leaves a consistent pair.
+    void snapshot(const collection_type& figures) {
+        std::lock_guard lock{mutex_};
+        snapshot_locked(figures);
+    }
+
+    void maybe_snapshot(const collection_type& figures) {
+        std::lock_guard lock{mutex_};
+        if (records_since_snapshot_ >= options_.snapshot_every) {
+            snapshot_locked(figures);
+        }
+    }
+
+private:
+    std::filesystem::path directory_;
+    JournalOptions options_;
+    mutable std::mutex mutex_;
+    int fd_{-1};
+    std::uint64_t generation_{0};
+    std::vector<char> buffer_;
+    std::size_t pending_records_{0};
+    std::chrono::steady_clock::time_point first_pending_{};
+    std::size_t records_since_snapshot_{0};
+
+    [[nodiscard]] std::filesystem::path log_path() const { return directory_ / "journal.log"; }
+    [[nodiscard]] std::filesystem::path snapshot_path() const { return directory_ / "snapshot.bin"; }
+
+    void commit_locked() {
+        if (buffer_.empty()) {
+            return;
+        }
+        ensure_log();
+        detail::write_all(fd_, buffer_.data(), buffer_.size(), "cannot append to " + log_path().string());
+        if (::fdatasync(fd_) != 0) {
+            detail::throw_errno("cannot sync " + log_path().string());
+        }
+        buffer_.clear();
+        pending_records_ = 0;
+    }
+
+    void snapshot_locked(const collection_type& figures) {
+        commit_locked();
+        const auto generation = generation_ + 1;
+
+        std::vector<char> content(detail::kSnapshotMagic, detail::kSnapshotMagic + sizeof(detail::kSnapshotMagic));
+        detail::put(content, generation);
+        detail::put(content, static_cast<std::uint64_t>(figures.size()));
+        for (const auto& figure : figures) {
+            const auto offset = content.size();
+            content.resize(offset + detail::kRecordHeaderSize);
+            detail::encode_figure(content, figure.get());
+            detail::seal_record(content, offset);
+        }
+
+        const auto temporary = directory_ / "snapshot.tmp";
+        const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            detail::throw_errno("cannot create " + temporary.string());
+        }
+        try {
+            detail::write_all(fd, content.data(), content.size(), "cannot write " + temporary.string());
+            if (::fsync(fd) != 0) {
+                detail::throw_errno("cannot sync " + temporary.string());
+            }
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        std::filesystem::rename(temporary, snapshot_path());
+        detail::sync_directory(directory_);
+
+        generation_ = generation;
+        open_log(0);
+        records_since_snapshot_ = 0;
+    }
+
+    std::size_t begin_record() {
+        const auto offset = buffer_.size();
+        buffer_.resize(offset + detail::kRecordHeaderSize);
+        return offset;
+    }
+
+    void end_record(std::size_t offset) {
+        detail::seal_record(buffer_, offset);
+        if (pending_records_++ == 0) {
+            first_pending_ = std::chrono::steady_clock::now();
+        }
+        ++records_since_snapshot_;
+        if (pending_records_ >= options_.group_commit_records) {
+            commit_locked();
+        }
+    }
+
+    void ensure_log() const {
+        if (fd_ < 0) {
+            throw std::logic_error("journal must be recovered before recording");
+        }
+    }
+
+    // Keeps the first `valid_size` bytes of the log (0 restarts it with a
+    // fresh header for the current generation) and positions at the end.
+    void open_log(std::size_t valid_size) {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        const auto path = log_path();
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            detail::throw_errno("cannot open " + path.string());
+        }
+        if (::ftruncate(fd_, static_cast<off_t>(valid_size)) != 0) {
+            detail::throw_errno("cannot truncate " + path.string());
+        }
+        if (::lseek(fd_, static_cast<off_t>(valid_size), SEEK_SET) < 0) {
+            detail::throw_errno("cannot seek " + path.string());
+        }
+        if (valid_size == 0) {
+            std::vector<char> header(detail::kJournalMagic, detail::kJournalMagic + sizeof(detail::kJournalMagic));
+            detail::put(header, generation_);
+            detail::write_all(fd_, header.data(), header.size(), "cannot write " + path.string());
+            if (::fdatasync(fd_) != 0) {
+                detail::throw_errno("cannot sync " + path.string());
+            }
+            detail::sync_directory(directory_);
+        }
+    }
+
+    void load_snapshot(const std::vector<char>& content, collection_type& figures) {
+        const char* cursor = content.data();
+        const char* end = cursor + content.size();
+        std::uint64_t generation = 0;
+        std::uint64_t count = 0;
+        if (content.size() < sizeof(detail::kSnapshotMagic) ||
+            std::memcmp(cursor, detail::kSnapshotMagic, sizeof(detail::kSnapshotMagic)) != 0) {
+            throw std::runtime_error("snapshot is corrupted");
+        }
+        cursor += sizeof(detail::kSnapshotMagic);
+        if (!detail::get(cursor, end, generation) || !detail::get(cursor, end, count)) {
+            throw std::runtime_error("snapshot is corrupted");
+        }
+        figures.reserve(count);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            const char* payload = nullptr;
+            const char* payload_end = nullptr;
+            std::shared_ptr<Figure<T>> figure;
+            if (!next_payload(cursor, end, payload, payload_end) || !decode_checked(payload, payload_end, figure)) {
+                throw std::runtime_error("snapshot is corrupted");
+            }
+            figures.push_back(std::move(figure));
+        }
+        generation_ = generation;
+    }
+
+    static bool next_payload(const char*& cursor, const char* end, const char*& payload, const char*& payload_end) {
+        std::uint32_t length = 0;
+        std::uint32_t checksum = 0;
+        const char* probe = cursor;
+        if (!detail::get(probe, end, length) || !detail::get(probe, end, checksum) ||
+            static_cast<std::size_t>(end - probe) < length || detail::fnv1a(probe, length) != checksum) {
+            return false;
+        }
+        payload = probe;
+        payload_end = probe + length;
+        cursor = payload_end;
+        return true;
+    }
+
+    // decode_figure() with the constructors' rejection of degenerate
+    // vertices reported as a failed decode.
+    static bool decode_checked(const char*& cursor, const char* end, std::shared_ptr<Figure<T>>& figure) {
+        try {
+            return detail::decode_figure(cursor, end, figure);
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+    }
+
+    // Applies the next log record. Returns false at a torn tail, i.e. a
+    // missing, short or mismatching checksummed record; throws if a sealed
+    // record cannot be applied, since no torn write produces one.
+    bool replay_record(const char*& cursor, const char* end, collection_type& figures, std::size_t number) {
+        const char* probe = cursor;
+        const char* payload = nullptr;
+        const char* payload_end = nullptr;
+        if (!next_payload(probe, end, payload, payload_end)) {
+            return false;
+        }
+        std::uint8_t op = 0;
+        bool applied = detail::get(payload, payload_end, op);
+        if (applied && op == static_cast<std::uint8_t>(detail::JournalOp::Add)) {
+            std::shared_ptr<Figure<T>> figure;
+            applied = decode_checked(payload, payload_end, figure);
+            if (applied) {
+                figures.push_back(std::move(figure));
+            }
+        } else if (applied && op == static_cast<std::uint8_t>(detail::JournalOp::Erase)) {
+            std::uint64_t index = 0;
+            applied = detail::get(payload, payload_end, index) && index < figures.size();
+            if (applied) {
+                figures.erase(static_cast<std::size_t>(index));
+            }
+        } else {
+            applied = false;
+        }
+        if (!applied) {
+            throw std::runtime_error("journal record " + std::to_string(number + 1) + " is corrupted");
+        }
+        cursor = probe;
+        return true;
+    }
+};
+
+}  // namespace lab04
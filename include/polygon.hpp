@@ -5,27 +5,40 @@
 #include <iomanip>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <stdexcept>
 #include <type_traits>
 
 #include "figure.hpp"
+#include "instrumentation.hpp"
+#include "predicates.hpp"
 
 namespace lab04 {
 
-template <Scalar T>
-bool almost_equal(T lhs, T rhs) {
-    if constexpr (std::is_floating_point_v<T>) {
-        const auto diff = std::fabs(lhs - rhs);
-        const auto scale = std::max({std::fabs(lhs), std::fabs(rhs), static_cast<T>(1)});
-        return diff <= static_cast<T>(std::numeric_limits<T>::epsilon() * 16) * scale;
-    }
-    return lhs == rhs;
-}
-
 template <typename Derived, Scalar T, std::size_t VertexCount>
 class PolygonFigure : public Figure<T> {
    public:
     using point_type = Point<T>;
-    using vertices_array = std::array<std::unique_ptr<point_type>, VertexCount>;
+
+    // Vertices normally live on the heap; copies made by clone_into() take
+    // them from the target resource and must hand them back there.
+    struct VertexDeleter {
+        std::pmr::memory_resource* resource{nullptr};
+
+        void operator()(point_type* vertex) const noexcept {
+            if (resource == nullptr) {
+                delete vertex;
+                return;
+            }
+            vertex->~point_type();
+            resource->deallocate(vertex, sizeof(point_type), alignof(point_type));
+        }
+    };
+
+    using vertex_pointer = std::unique_ptr<point_type, VertexDeleter>;
+    using vertices_array = std::array<vertex_pointer, VertexCount>;
 
     PolygonFigure() = default;
 
@@ -39,8 +52,15 @@ class PolygonFigure : public Figure<T> {
         return *this;
     }
 
-    PolygonFigure(PolygonFigure&&) noexcept = default;
-    PolygonFigure& operator=(PolygonFigure&&) noexcept = default;
+    // Vertices placed in a resource (snapshot copies) are copied to the heap
+    // rather than moved, so the result never outlives the resource.
+    PolygonFigure(PolygonFigure&& other) { take_from(other); }
+    PolygonFigure& operator=(PolygonFigure&& other) {
+        if (this != &other) {
+            take_from(other);
+        }
+        return *this;
+    }
 
     ~PolygonFigure() override = default;
 
@@ -57,6 +77,7 @@ class PolygonFigure : public Figure<T> {
     }
 
     [[nodiscard]] double area() const override {
+        LAB04_TRACE_SCOPE("PolygonFigure::area");
         long double result = 0.0L;
         for (std::size_t i = 0; i < VertexCount; ++i) {
             const auto& current = *vertices_[i];
@@ -67,6 +88,28 @@ class PolygonFigure : public Figure<T> {
         return std::fabs(static_cast<double>(result) * 0.5);
     }
 
+    [[nodiscard]] bool contains(const point_type& point) const override {
+        using real = std::common_type_t<T, double>;
+        bool has_positive = false;
+        bool has_negative = false;
+        for (std::size_t i = 0; i < VertexCount; ++i) {
+            const auto& current = *vertices_[i];
+            const auto& next = *vertices_[(i + 1) % VertexCount];
+            const auto edge_x = static_cast<real>(next.x()) - static_cast<real>(current.x());
+            const auto edge_y = static_cast<real>(next.y()) - static_cast<real>(current.y());
+            const auto to_x = static_cast<real>(point.x()) - static_cast<real>(current.x());
+            const auto to_y = static_cast<real>(point.y()) - static_cast<real>(current.y());
+            const auto lhs = edge_x * to_y;
+            const auto rhs = edge_y * to_x;
+            const auto cross = lhs - rhs;
+            const auto tolerance =
+                std::numeric_limits<real>::epsilon() * 16 * (std::fabs(lhs) + std::fabs(rhs));
+            has_positive = has_positive || cross > tolerance;
+            has_negative = has_negative || cross < -tolerance;
+        }
+        return !(has_positive && has_negative);
+    }
+
     void print(std::ostream& os) const override {
         const auto previous_flags = os.flags();
         const auto previous_precision = os.precision();
@@ -85,6 +128,38 @@ class PolygonFigure : public Figure<T> {
         os.precision(previous_precision);
     }
 
+    [[nodiscard]] std::size_t snapshot_footprint() const override {
+        return arena_footprint<Derived>() + VertexCount * arena_footprint<point_type>();
+    }
+
+    [[nodiscard]] Figure<T>* clone_into(std::pmr::memory_resource& resource) const override {
+        return place_vertices(resource, vertices());
+    }
+
+    // Constructs a Derived with the given vertices in `resource`, vertices
+    // included, without any validation; bulk factories check their rows up
+    // front.
+    [[nodiscard]] static Derived* place_vertices(std::pmr::memory_resource& resource,
+                                                 const std::array<point_type, VertexCount>& points) {
+        void* memory = resource.allocate(sizeof(Derived), alignof(Derived));
+        auto* figure = ::new (memory) Derived();
+        auto& target = static_cast<PolygonFigure&>(*figure).vertices_;
+        for (std::size_t i = 0; i < VertexCount; ++i) {
+            void* slot = resource.allocate(sizeof(point_type), alignof(point_type));
+            target[i] = vertex_pointer(::new (slot) point_type(points[i]), VertexDeleter{&resource});
+        }
+        return figure;
+    }
+
+    [[nodiscard]] std::size_t vertex_count() const override { return VertexCount; }
+
+    [[nodiscard]] point_type vertex(std::size_t index) const override {
+        if (index >= VertexCount) {
+            throw std::out_of_range("vertex index out of range");
+        }
+        return *vertices_[index];
+    }
+
     [[nodiscard]] std::array<point_type, VertexCount> vertices() const {
         std::array<point_type, VertexCount> result{};
         for (std::size_t i = 0; i < VertexCount; ++i) {
@@ -98,24 +173,30 @@ class PolygonFigure : public Figure<T> {
 
     void assign(const std::array<point_type, VertexCount>& points) {
         for (std::size_t i = 0; i < VertexCount; ++i) {
-            vertices_[i] = std::make_unique<point_type>(points[i]);
+            vertices_[i] = vertex_pointer(new point_type(points[i]));
         }
     }
 
     void copy_from(const PolygonFigure& other) {
         for (std::size_t i = 0; i < VertexCount; ++i) {
-            vertices_[i] = std::make_unique<point_type>(*other.vertices_[i]);
+            vertices_[i] = vertex_pointer(new point_type(*other.vertices_[i]));
         }
     }
 
-    [[nodiscard]] bool is_equal(const PolygonFigure& other) const {
-        for (std::size_t i = 0; i < VertexCount; ++i) {
-            if (!almost_equal(vertices_[i]->x(), other.vertices_[i]->x()) ||
-                !almost_equal(vertices_[i]->y(), other.vertices_[i]->y())) {
-                return false;
+    void take_from(PolygonFigure& other) {
+        for (const auto& vertex : other.vertices_) {
+            if (vertex && vertex.get_deleter().resource != nullptr) {
+                copy_from(other);
+                return;
             }
         }
-        return true;
+        vertices_ = std::move(other.vertices_);
+    }
+
+    [[nodiscard]] bool is_equal(const PolygonFigure& other) const {
+        const auto mine = vertices();
+        const auto theirs = other.vertices();
+        return almost_equal<T>(std::span<const point_type>{mine}, std::span<const point_type>{theirs});
     }
 
     [[nodiscard]] bool is_equal(const Figure<T>& other) const override {
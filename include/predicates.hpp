@@ -0,0 +1,463 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "point.hpp"
+
+namespace lab04 {
+
+// Coordinate equality: relative tolerance of 16 epsilon, absolute below 1,
+// exact for integral T. Identical values, by far the usual case when a copy
+// is compared with its original, never reach the scaled comparison.
+template <Scalar T>
+[[nodiscard]] bool almost_equal(T lhs, T rhs) {
+    if (lhs == rhs) {
+        return true;
+    }
+    if constexpr (std::is_floating_point_v<T>) {
+        const auto diff = std::fabs(lhs - rhs);
+        const auto scale = std::max(std::max(std::fabs(lhs), std::fabs(rhs)), static_cast<T>(1));
+        return diff <= static_cast<T>(std::numeric_limits<T>::epsilon() * 16) * scale;
+    } else {
+        return false;
+    }
+}
+
+namespace detail {
+
+// almost_equal() without the early exit, for loops the compiler vectorizes.
+template <Scalar T>
+[[nodiscard]] bool nearly_equal(T lhs, T rhs) {
+    if constexpr (std::is_floating_point_v<T>) {
+        const auto diff = std::fabs(lhs - rhs);
+        const auto scale = std::max(std::max(std::fabs(lhs), std::fabs(rhs)), static_cast<T>(1));
+        return lhs == rhs || diff <= static_cast<T>(std::numeric_limits<T>::epsilon() * 16) * scale;
+    } else {
+        return lhs == rhs;
+    }
+}
+
+}  // namespace detail
+
+// Batch coordinate equality: whether both spans have the same length and
+// every pair of points is almost_equal() in both coordinates. All pairs are
+// compared, without stopping at the first mismatch, then the mismatches
+// counted.
+template <Scalar T>
+[[nodiscard]] bool almost_equal(std::span<const Point<T>> lhs, std::span<const Point<T>> rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        mismatches += static_cast<std::size_t>(
+            !(detail::nearly_equal(lhs[i].x(), rhs[i].x()) && detail::nearly_equal(lhs[i].y(), rhs[i].y())));
+    }
+    return mismatches == 0;
+}
+
+namespace detail {
+
+// Whether every value of T converts to double exactly, which the exact
+// fallback below relies on: float, double and integers up to 53 bits.
+template <Scalar T>
+inline constexpr bool kExactInDouble = std::is_same_v<T, float> || std::is_same_v<T, double> ||
+                                       (std::is_integral_v<T> && std::numeric_limits<T>::digits <= 53);
+
+// Default tolerance of equidistant(), that of almost_equal() on the type the
+// distances are compared in.
+template <Scalar T>
+inline constexpr double kDistanceTolerance =
+    static_cast<double>(std::numeric_limits<std::common_type_t<T, double>>::epsilon() * 16);
+
+// Other types (long double, 64-bit integers) are evaluated directly in long
+// double, which keeps all their bits where it is wider than double; the
+// result is not guaranteed exact.
+template <Scalar T>
+[[nodiscard]] int wide_orientation(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    using wide = long double;
+    const auto det = (static_cast<wide>(b.x()) - static_cast<wide>(a.x())) *
+                         (static_cast<wide>(c.y()) - static_cast<wide>(a.y())) -
+                     (static_cast<wide>(b.y()) - static_cast<wide>(a.y())) *
+                         (static_cast<wide>(c.x()) - static_cast<wide>(a.x()));
+    return static_cast<int>(det > 0) - static_cast<int>(det < 0);
+}
+
+template <Scalar T>
+[[nodiscard]] std::pair<long double, long double> wide_distances(const Point<T>& o, const Point<T>& p,
+                                                                 const Point<T>& q) {
+    using wide = long double;
+    const auto px = static_cast<wide>(p.x()) - static_cast<wide>(o.x());
+    const auto py = static_cast<wide>(p.y()) - static_cast<wide>(o.y());
+    const auto qx = static_cast<wide>(q.x()) - static_cast<wide>(o.x());
+    const auto qy = static_cast<wide>(q.y()) - static_cast<wide>(o.y());
+    return {px * px + py * py, qx * qx + qy * qy};
+}
+
+template <Scalar T>
+[[nodiscard]] bool wide_equidistant(const Point<T>& o, const Point<T>& p, const Point<T>& q,
+                                    double relative_tolerance) {
+    const auto [to_p, to_q] = wide_distances(o, p, q);
+    return std::fabs(to_p - to_q) <=
+           static_cast<long double>(relative_tolerance) * std::max(std::max(to_p, to_q), 1.0L);
+}
+
+// Unit roundoff of double, Shewchuk's epsilon.
+inline constexpr double kRoundoff = std::numeric_limits<double>::epsilon() / 2;
+inline constexpr double kOrientationBound = (3.0 + 16.0 * kRoundoff) * kRoundoff;
+inline constexpr double kDistanceBound = 8.0 * kRoundoff;
+
+// Exact sum of up to Capacity doubles kept as a nonoverlapping expansion in
+// increasing magnitude (Shewchuk, "Adaptive Precision Floating-Point
+// Arithmetic and Fast Robust Geometric Predicates"). Products enter as two
+// terms, so Capacity / 2 of them fit. Assumes no overflow or underflow.
+template <std::size_t Capacity>
+class ExactSum {
+public:
+    void add(double value) noexcept {
+        double carry = value;
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < size_; ++i) {
+            const auto sum = carry + terms_[i];
+            const auto virtual_term = sum - carry;
+            const auto error = (carry - (sum - virtual_term)) + (terms_[i] - virtual_term);
+            carry = sum;
+            if (error != 0.0) {
+                terms_[kept++] = error;
+            }
+        }
+        if (carry != 0.0) {
+            terms_[kept++] = carry;
+        }
+        size_ = kept;
+    }
+
+    void add_product(double lhs, double rhs) noexcept {
+        const auto product = lhs * rhs;
+        add(std::fma(lhs, rhs, -product));
+        add(product);
+    }
+
+    // The largest term carries the sign of the whole sum.
+    [[nodiscard]] int sign() const noexcept {
+        return size_ == 0 ? 0 : (terms_[size_ - 1] > 0.0 ? 1 : -1);
+    }
+
+    [[nodiscard]] double estimate() const noexcept {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < size_; ++i) {
+            sum += terms_[i];
+        }
+        return sum;
+    }
+
+private:
+    std::array<double, Capacity> terms_{};
+    std::size_t size_{0};
+};
+
+template <Scalar T>
+[[nodiscard]] int exact_orientation(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    const auto ax = static_cast<double>(a.x());
+    const auto ay = static_cast<double>(a.y());
+    const auto bx = static_cast<double>(b.x());
+    const auto by = static_cast<double>(b.y());
+    const auto cx = static_cast<double>(c.x());
+    const auto cy = static_cast<double>(c.y());
+    ExactSum<12> det;
+    det.add_product(ax, by);
+    det.add_product(-ax, cy);
+    det.add_product(-ay, bx);
+    det.add_product(ay, cx);
+    det.add_product(bx, cy);
+    det.add_product(-by, cx);
+    return det.sign();
+}
+
+// |o - p|^2 - |o - q|^2 expanded so that only products of input
+// coordinates appear; the squares of o cancel.
+template <Scalar T>
+[[nodiscard]] ExactSum<16> exact_distance_difference(const Point<T>& o, const Point<T>& p, const Point<T>& q) {
+    const auto ox = static_cast<double>(o.x());
+    const auto oy = static_cast<double>(o.y());
+    const auto px = static_cast<double>(p.x());
+    const auto py = static_cast<double>(p.y());
+    const auto qx = static_cast<double>(q.x());
+    const auto qy = static_cast<double>(q.y());
+    ExactSum<16> difference;
+    difference.add_product(px, px);
+    difference.add_product(py, py);
+    difference.add_product(-qx, qx);
+    difference.add_product(-qy, qy);
+    difference.add_product(-2.0 * ox, px);
+    difference.add_product(-2.0 * oy, py);
+    difference.add_product(2.0 * ox, qx);
+    difference.add_product(2.0 * oy, qy);
+    return difference;
+}
+
+struct FilteredDistances {
+    double to_p;
+    double to_q;
+    double difference;
+    double error;
+};
+
+template <Scalar T>
+[[nodiscard]] FilteredDistances filtered_distances(const Point<T>& o, const Point<T>& p, const Point<T>& q) {
+    const auto px = static_cast<double>(p.x()) - static_cast<double>(o.x());
+    const auto py = static_cast<double>(p.y()) - static_cast<double>(o.y());
+    const auto qx = static_cast<double>(q.x()) - static_cast<double>(o.x());
+    const auto qy = static_cast<double>(q.y()) - static_cast<double>(o.y());
+    const auto to_p = px * px + py * py;
+    const auto to_q = qx * qx + qy * qy;
+    return FilteredDistances{to_p, to_q, to_p - to_q, kDistanceBound * (to_p + to_q)};
+}
+
+// equidistant() decided by the filter alone: 1 or 0, or kUndecided when
+// the difference lies within the rounding error of the threshold.
+inline constexpr unsigned char kUndecided = 2;
+
+template <Scalar T>
+[[nodiscard]] unsigned char filtered_equidistant(const Point<T>& o, const Point<T>& p, const Point<T>& q,
+                                                 double relative_tolerance) {
+    const auto filtered = filtered_distances(o, p, q);
+    const auto threshold = relative_tolerance * std::max(std::max(filtered.to_p, filtered.to_q), 1.0);
+    const auto error = filtered.error + 4.0 * kRoundoff * threshold;
+    const auto difference = std::fabs(filtered.difference);
+    const auto surely = static_cast<unsigned char>(difference + error <= threshold);
+    const auto maybe = static_cast<unsigned char>(difference - error <= threshold);
+    return static_cast<unsigned char>(2 * maybe - surely);
+}
+
+template <Scalar T>
+[[nodiscard]] bool exact_equidistant(const Point<T>& o, const Point<T>& p, const Point<T>& q,
+                                     double relative_tolerance) {
+    const auto filtered = filtered_distances(o, p, q);
+    const auto threshold = relative_tolerance * std::max(std::max(filtered.to_p, filtered.to_q), 1.0);
+    const auto exact = exact_distance_difference(o, p, q);
+    return relative_tolerance == 0.0 ? exact.sign() == 0 : std::fabs(exact.estimate()) <= threshold;
+}
+
+template <typename Size>
+void require_same_size(Size first, Size second, Size third, Size fourth) {
+    if (first != second || first != third || first != fourth) {
+        throw std::invalid_argument("predicate batches differ in length");
+    }
+}
+
+}  // namespace detail
+
+// Geometric predicates on coordinates taken as doubles; they are exact for
+// every coordinate a double represents, i.e. all float and double values and
+// integers up to 2^53. A floating-point evaluation with a forward error
+// bound decides almost every call; only inputs whose result falls inside
+// the bound are redone in exact expansion arithmetic. Wider types take the
+// long double path above instead of losing bits to double.
+
+// Sign of the turn a -> b -> c: 1 counter-clockwise, -1 clockwise, 0 collinear.
+template <Scalar T>
+[[nodiscard]] int orientation(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    if constexpr (!detail::kExactInDouble<T>) {
+        return detail::wide_orientation(a, b, c);
+    }
+    const auto left = (static_cast<double>(a.x()) - static_cast<double>(c.x())) *
+                      (static_cast<double>(b.y()) - static_cast<double>(c.y()));
+    const auto right = (static_cast<double>(a.y()) - static_cast<double>(c.y())) *
+                       (static_cast<double>(b.x()) - static_cast<double>(c.x()));
+    const auto det = left - right;
+    const auto bound = detail::kOrientationBound * (std::fabs(left) + std::fabs(right));
+    if (det > bound) {
+        return 1;
+    }
+    if (-det > bound) {
+        return -1;
+    }
+    return detail::exact_orientation(a, b, c);
+}
+
+// Sign of |origin - p| - |origin - q|: -1 when p is closer, 1 when q is.
+template <Scalar T>
+[[nodiscard]] int compare_distance(const Point<T>& origin, const Point<T>& p, const Point<T>& q) {
+    if constexpr (!detail::kExactInDouble<T>) {
+        const auto [to_p, to_q] = detail::wide_distances(origin, p, q);
+        return static_cast<int>(to_p > to_q) - static_cast<int>(to_p < to_q);
+    }
+    const auto filtered = detail::filtered_distances(origin, p, q);
+    if (filtered.difference > filtered.error) {
+        return 1;
+    }
+    if (-filtered.difference > filtered.error) {
+        return -1;
+    }
+    return detail::exact_distance_difference(origin, p, q).sign();
+}
+
+// Whether p and q lie at the same distance from `origin` up to a relative
+// tolerance on the squared distances, absolute below 1, as almost_equal
+// applies it. The difference is evaluated exactly when the filter cannot
+// decide, so large coordinates no longer swamp it with rounding error.
+template <Scalar T>
+[[nodiscard]] bool equidistant(const Point<T>& origin, const Point<T>& p, const Point<T>& q,
+                               double relative_tolerance = detail::kDistanceTolerance<T>) {
+    if constexpr (!detail::kExactInDouble<T>) {
+        return detail::wide_equidistant(origin, p, q, relative_tolerance);
+    }
+    const auto decided = detail::filtered_equidistant(origin, p, q, relative_tolerance);
+    return decided == detail::kUndecided ? detail::exact_equidistant(origin, p, q, relative_tolerance)
+                                         : decided == 1;
+}
+
+// Turn direction of a convex outline: 1 counter-clockwise, -1 clockwise,
+// 0 when it is not convex. Collinear vertices are allowed. Besides sharing
+// one sign, the turns must add up to a single full turn; a star polygon
+// such as a pentagram turns one way throughout but winds twice, and only
+// the even-odd rule describes it.
+[[nodiscard]] inline int convex_orientation(std::span<const Point<double>> vertices) {
+    constexpr double kPi = 3.14159265358979323846;
+    const auto count = vertices.size();
+    if (count < 3) {
+        return 0;
+    }
+    int turn = 0;
+    double winding = 0.0;
+    for (std::size_t i = 0, j = count - 1, k = count - 2; i < count; k = j, j = i++) {
+        const auto& a = vertices[k];
+        const auto& b = vertices[j];
+        const auto& c = vertices[i];
+        const int sign = orientation(a, b, c);
+        if (sign != 0 && turn != 0 && sign != turn) {
+            return 0;
+        }
+        turn = sign != 0 ? sign : turn;
+        const auto cross = (b.x() - a.x()) * (c.y() - b.y()) - (b.y() - a.y()) * (c.x() - b.x());
+        const auto dot = (b.x() - a.x()) * (c.x() - b.x()) + (b.y() - a.y()) * (c.y() - b.y());
+        winding += std::atan2(cross, dot);
+    }
+    // Exactly 2 pi for one turn, 4 pi or more for a star; 3 pi splits them
+    // whatever the rounding of the angles.
+    return std::fabs(winding) < 3.0 * kPi ? turn : 0;
+}
+
+namespace detail {
+
+// Andrew's monotone chain; sorts `points` in place and returns the hull
+// counter-clockwise without collinear vertices. Turns are decided by
+// orientation(), so every hull built on it agrees on near-collinear input.
+template <Scalar T>
+std::vector<Point<T>> monotone_chain(std::vector<Point<T>>& points) {
+    std::sort(points.begin(), points.end(), [](const Point<T>& lhs, const Point<T>& rhs) {
+        return lhs.x() < rhs.x() || (lhs.x() == rhs.x() && lhs.y() < rhs.y());
+    });
+    points.erase(std::unique(points.begin(), points.end(),
+                             [](const Point<T>& lhs, const Point<T>& rhs) {
+                                 return lhs.x() == rhs.x() && lhs.y() == rhs.y();
+                             }),
+                 points.end());
+    if (points.size() < 3) {
+        return points;
+    }
+    std::vector<Point<T>> hull(2 * points.size());
+    std::size_t size = 0;
+    for (const auto& point : points) {
+        while (size >= 2 && orientation(hull[size - 2], hull[size - 1], point) <= 0) {
+            --size;
+        }
+        hull[size++] = point;
+    }
+    const auto lower_size = size + 1;
+    for (auto it = points.rbegin() + 1; it != points.rend(); ++it) {
+        while (size >= lower_size && orientation(hull[size - 2], hull[size - 1], *it) <= 0) {
+            --size;
+        }
+        hull[size++] = *it;
+    }
+    hull.resize(size - 1);
+    return hull;
+}
+
+}  // namespace detail
+
+// Batch forms: signs[i] is the predicate for the i-th entries. The filter
+// runs over the whole batch first without branches; the exact fallback then
+// revisits only the entries it left undecided. Spans of different length
+// throw std::invalid_argument.
+template <Scalar T>
+void orientation(std::span<const Point<T>> a, std::span<const Point<T>> b, std::span<const Point<T>> c,
+                 std::span<int> signs) {
+    detail::require_same_size(a.size(), b.size(), c.size(), signs.size());
+    if constexpr (!detail::kExactInDouble<T>) {
+        for (std::size_t i = 0; i < signs.size(); ++i) {
+            signs[i] = detail::wide_orientation(a[i], b[i], c[i]);
+        }
+        return;
+    }
+    for (std::size_t i = 0; i < signs.size(); ++i) {
+        const auto left = (static_cast<double>(a[i].x()) - static_cast<double>(c[i].x())) *
+                          (static_cast<double>(b[i].y()) - static_cast<double>(c[i].y()));
+        const auto right = (static_cast<double>(a[i].y()) - static_cast<double>(c[i].y())) *
+                           (static_cast<double>(b[i].x()) - static_cast<double>(c[i].x()));
+        const auto det = left - right;
+        const auto bound = detail::kOrientationBound * (std::fabs(left) + std::fabs(right));
+        signs[i] = static_cast<int>(det > bound) - static_cast<int>(-det > bound);
+    }
+    for (std::size_t i = 0; i < signs.size(); ++i) {
+        if (signs[i] == 0) {
+            signs[i] = detail::exact_orientation(a[i], b[i], c[i]);
+        }
+    }
+}
+
+template <Scalar T>
+void compare_distance(std::span<const Point<T>> origin, std::span<const Point<T>> p, std::span<const Point<T>> q,
+                      std::span<int> signs) {
+    detail::require_same_size(origin.size(), p.size(), q.size(), signs.size());
+    if constexpr (!detail::kExactInDouble<T>) {
+        for (std::size_t i = 0; i < signs.size(); ++i) {
+            signs[i] = compare_distance(origin[i], p[i], q[i]);
+        }
+        return;
+    }
+    for (std::size_t i = 0; i < signs.size(); ++i) {
+        const auto filtered = detail::filtered_distances(origin[i], p[i], q[i]);
+        signs[i] = static_cast<int>(filtered.difference > filtered.error) -
+                   static_cast<int>(-filtered.difference > filtered.error);
+    }
+    for (std::size_t i = 0; i < signs.size(); ++i) {
+        if (signs[i] == 0) {
+            signs[i] = detail::exact_distance_difference(origin[i], p[i], q[i]).sign();
+        }
+    }
+}
+
+// equal[i] is 1 when origin[i] is equidistant from p[i] and q[i], else 0.
+template <Scalar T>
+void equidistant(std::span<const Point<T>> origin, std::span<const Point<T>> p, std::span<const Point<T>> q,
+                 std::span<unsigned char> equal, double relative_tolerance = detail::kDistanceTolerance<T>) {
+    detail::require_same_size(origin.size(), p.size(), q.size(), equal.size());
+    if constexpr (!detail::kExactInDouble<T>) {
+        for (std::size_t i = 0; i < equal.size(); ++i) {
+            equal[i] = detail::wide_equidistant(origin[i], p[i], q[i], relative_tolerance);
+        }
+        return;
+    }
+    for (std::size_t i = 0; i < equal.size(); ++i) {
+        equal[i] = detail::filtered_equidistant(origin[i], p[i], q[i], relative_tolerance);
+    }
+    for (std::size_t i = 0; i < equal.size(); ++i) {
+        if (equal[i] == detail::kUndecided) {
+            equal[i] = detail::exact_equidistant(origin[i], p[i], q[i], relative_tolerance);
+        }
+    }
+}
+
+}  // namespace lab04
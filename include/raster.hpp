@@ -0,0 +1,487 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <ostream>
+#include <stdexcept>
+#include <stop_token>
+#include <vector>
+
+#include "array.hpp"
+#include "figure.hpp"
+#include "predicates.hpp"
+#include "task_executor.hpp"
+
+namespace lab04 {
+
+struct Viewport {
+    Point<double> min{};
+    Point<double> max{};
+};
+
+struct RasterOptions {
+    std::size_t width{1024};
+    std::size_t height{1024};
+    std::size_t tile_size{64};
+    std::size_t thread_count{0};
+    // Defaults to the bounding box of all vertices.
+    std::optional<Viewport> viewport{};
+};
+
+// Number of figures covering each pixel center; row 0 is the top of the image.
+class CoverageGrid {
+public:
+    CoverageGrid() = default;
+    CoverageGrid(std::size_t width, std::size_t height) : width_(width), height_(height), counts_(width * height) {}
+
+    [[nodiscard]] std::size_t width() const noexcept { return width_; }
+    [[nodiscard]] std::size_t height() const noexcept { return height_; }
+
+    [[nodiscard]] std::uint32_t at(std::size_t x, std::size_t y) const {
+        if (x >= width_ || y >= height_) {
+            throw std::out_of_range("pixel out of range");
+        }
+        return counts_[y * width_ + x];
+    }
+
+    [[nodiscard]] std::uint32_t max() const noexcept {
+        return counts_.empty() ? 0 : *std::max_element(counts_.begin(), counts_.end());
+    }
+
+    [[nodiscard]] std::uint32_t* row(std::size_t y) noexcept { return counts_.data() + y * width_; }
+    [[nodiscard]] const std::uint32_t* row(std::size_t y) const noexcept { return counts_.data() + y * width_; }
+
+private:
+    std::size_t width_{0};
+    std::size_t height_{0};
+    std::vector<std::uint32_t> counts_;
+};
+
+namespace detail {
+
+// One figure in pixel coordinates. The bounding box holds the pixels whose
+// centers it may cover, clipped to the image; a figure too small to cover
+// any pixel center is splatted onto the pixel holding its first vertex so
+// the density still accounts for it.
+struct ScreenPrimitive {
+    std::size_t first{0};
+    std::size_t count{0};
+    std::ptrdiff_t min_x{0};
+    std::ptrdiff_t min_y{0};
+    std::ptrdiff_t max_x{-1};
+    std::ptrdiff_t max_y{-1};
+    double side{1.0};
+    bool convex{true};
+    bool splat{false};
+};
+
+// Runs fn(first, last) over chunks of `grain` items of [0, count) on the
+// pool, or in one call on the calling thread without one.
+template <typename Fn>
+void run_chunks(ThreadPool* pool, std::size_t count, std::size_t grain, Fn&& fn) {
+    if (pool == nullptr) {
+        fn(std::size_t{0}, count);
+    } else if (count > 0) {
+        pool->parallel_for(count, grain, fn);
+    }
+}
+
+// Bounds beyond any image; clamping to them keeps the pixel index casts
+// below in range of std::ptrdiff_t.
+inline constexpr double kPixelLimit = 1e15;
+
+// Pixel centers px + 0.5 within [low, high]. Infinite bounds are clamped to
+// kPixelLimit; NaN must be rejected by the caller.
+inline std::ptrdiff_t first_center(double low) {
+    return static_cast<std::ptrdiff_t>(std::ceil(std::clamp(low, -kPixelLimit, kPixelLimit) - 0.5));
+}
+inline std::ptrdiff_t last_center(double high) {
+    return static_cast<std::ptrdiff_t>(std::floor(std::clamp(high, -kPixelLimit, kPixelLimit) - 0.5));
+}
+
+inline void fill_span(std::uint32_t* row, double low, double high, std::ptrdiff_t min_x, std::ptrdiff_t max_x) {
+    if (!(low <= high)) {
+        return;
+    }
+    const auto first = std::max(min_x, first_center(low));
+    const auto last = std::min(max_x, last_center(high));
+    for (auto x = first; x <= last; ++x) {
+        ++row[x];
+    }
+}
+
+// Edge function A*x + B*y + C >= 0 of a convex polygon, solved for x: on a
+// row y the bound is (B*y + C) * scale, from below when `lower` is set.
+// Horizontal edges (scale 0) instead accept or reject the whole row.
+struct EdgeBound {
+    double b;
+    double c;
+    double scale;
+    bool lower;
+};
+
+// Convex polygons: every edge bounds x from one side, so the covered pixels
+// of a row form one span. `side` is the sign of the polygon's area.
+inline void fill_convex(CoverageGrid& grid, const Point<double>* vertices, std::size_t count, double side,
+                        std::ptrdiff_t min_x, std::ptrdiff_t min_y, std::ptrdiff_t max_x, std::ptrdiff_t max_y,
+                        std::vector<EdgeBound>& edges) {
+    edges.clear();
+    for (std::size_t i = 0, j = count - 1; i < count; j = i++) {
+        const auto& a = vertices[j];
+        const auto& b = vertices[i];
+        const auto step_x = side * (a.y() - b.y());
+        const auto step_y = side * (b.x() - a.x());
+        const auto offset = side * (b.y() - a.y()) * a.x() - step_y * a.y();
+        edges.push_back(EdgeBound{step_y, offset, step_x == 0.0 ? 0.0 : -1.0 / step_x, step_x > 0.0});
+    }
+    for (auto y = min_y; y <= max_y; ++y) {
+        const auto center_y = static_cast<double>(y) + 0.5;
+        double low = -std::numeric_limits<double>::infinity();
+        double high = std::numeric_limits<double>::infinity();
+        for (const auto& edge : edges) {
+            const auto value = edge.b * center_y + edge.c;
+            if (edge.scale == 0.0) {
+                if (value < 0.0) {
+                    high = -std::numeric_limits<double>::infinity();
+                }
+            } else if (edge.lower) {
+                low = std::max(low, value * edge.scale);
+            } else {
+                high = std::min(high, value * edge.scale);
+            }
+        }
+        if (low <= high) {
+            fill_span(grid.row(static_cast<std::size_t>(y)), low, high, min_x, max_x);
+        }
+    }
+}
+
+// Other simple polygons: even-odd rule over the edge crossings of each row.
+inline void fill_crossings(CoverageGrid& grid, const Point<double>* vertices, std::size_t count,
+                           std::ptrdiff_t min_x, std::ptrdiff_t min_y, std::ptrdiff_t max_x, std::ptrdiff_t max_y,
+                           std::vector<double>& crossings) {
+    for (auto y = min_y; y <= max_y; ++y) {
+        const auto center_y = static_cast<double>(y) + 0.5;
+        crossings.clear();
+        for (std::size_t i = 0, j = count - 1; i < count; j = i++) {
+            const auto& a = vertices[j];
+            const auto& b = vertices[i];
+            if ((a.y() <= center_y) != (b.y() <= center_y)) {
+                crossings.push_back(a.x() + (center_y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for (std::size_t i = 0; i + 1 < crossings.size(); i += 2) {
+            fill_span(grid.row(static_cast<std::size_t>(y)), crossings[i], crossings[i + 1], min_x, max_x);
+        }
+    }
+}
+
+[[nodiscard]] inline double area_sign(const Point<double>* vertices, std::size_t count) {
+    double doubled_area = 0.0;
+    for (std::size_t i = 0, j = count - 1; i < count; j = i++) {
+        doubled_area += vertices[j].x() * vertices[i].y() - vertices[j].y() * vertices[i].x();
+    }
+    return doubled_area < 0.0 ? -1.0 : 1.0;
+}
+
+// The phases of rasterize() below, run as chunks on `pool` when given and
+// on the calling thread otherwise. `stop` is polled between phases and per
+// tile; nothing is returned once it was requested.
+template <Scalar T, typename Growth>
+std::optional<CoverageGrid> rasterize_on(const Array<std::shared_ptr<Figure<T>>, Growth>& figures,
+                                         const RasterOptions& options, ThreadPool* pool,
+                                         const std::stop_token& stop) {
+    if (options.width == 0 || options.height == 0) {
+        throw std::invalid_argument("image size must be positive");
+    }
+    if (options.tile_size == 0) {
+        throw std::invalid_argument("tile size must be positive");
+    }
+    // A few chunks per thread so that stealing evens out uneven figures.
+    const auto chunks = pool == nullptr ? std::size_t{1} : pool->size() * 4;
+    const auto grain = std::max<std::size_t>(1, (figures.size() + chunks - 1) / chunks);
+    const auto width = static_cast<std::ptrdiff_t>(options.width);
+    const auto height = static_cast<std::ptrdiff_t>(options.height);
+    CoverageGrid grid{options.width, options.height};
+
+    std::vector<ScreenPrimitive> primitives(figures.size());
+    std::size_t vertex_total = 0;
+    for (std::size_t i = 0; i < figures.size(); ++i) {
+        primitives[i].first = vertex_total;
+        if (figures[i]) {
+            primitives[i].count = figures[i]->vertex_count();
+            vertex_total += primitives[i].count;
+        }
+    }
+    std::vector<Point<double>> vertices(vertex_total);
+    constexpr auto kInfinity = std::numeric_limits<double>::infinity();
+    const Viewport empty{Point<double>{kInfinity, kInfinity}, Point<double>{-kInfinity, -kInfinity}};
+    std::vector<Viewport> slice_bounds(std::max<std::size_t>(1, (figures.size() + grain - 1) / grain), empty);
+    run_chunks(pool, figures.size(), grain, [&](std::size_t first, std::size_t last) {
+        auto& bounds = slice_bounds[first / grain];
+        for (auto i = first; i < last; ++i) {
+            const auto& primitive = primitives[i];
+            for (std::size_t k = 0; k < primitive.count; ++k) {
+                const auto vertex = figures[i]->vertex(k);
+                const Point<double> point{static_cast<double>(vertex.x()), static_cast<double>(vertex.y())};
+                vertices[primitive.first + k] = point;
+                // Non-finite vertices would stretch the viewport to nothing;
+                // their figures are dropped below.
+                if (!std::isfinite(point.x()) || !std::isfinite(point.y())) {
+                    continue;
+                }
+                bounds.min = Point<double>{std::min(bounds.min.x(), point.x()), std::min(bounds.min.y(), point.y())};
+                bounds.max = Point<double>{std::max(bounds.max.x(), point.x()), std::max(bounds.max.y(), point.y())};
+            }
+        }
+    });
+
+    auto viewport = slice_bounds.front();
+    if (options.viewport) {
+        viewport = *options.viewport;
+    } else {
+        for (const auto& bounds : slice_bounds) {
+            viewport.min = Point<double>{std::min(viewport.min.x(), bounds.min.x()),
+                                         std::min(viewport.min.y(), bounds.min.y())};
+            viewport.max = Point<double>{std::max(viewport.max.x(), bounds.max.x()),
+                                         std::max(viewport.max.y(), bounds.max.y())};
+        }
+    }
+    if (stop.stop_requested()) {
+        return std::nullopt;
+    }
+    if (vertex_total == 0 || !(viewport.max.x() >= viewport.min.x()) || !(viewport.max.y() >= viewport.min.y())) {
+        return grid;
+    }
+    auto scale = std::max((viewport.max.x() - viewport.min.x()) / static_cast<double>(width),
+                          (viewport.max.y() - viewport.min.y()) / static_cast<double>(height));
+    if (!(scale > 0.0)) {
+        scale = 1.0;
+    }
+    const auto center_x = (viewport.min.x() + viewport.max.x()) / 2.0;
+    const auto center_y = (viewport.min.y() + viewport.max.y()) / 2.0;
+
+    run_chunks(pool, figures.size(), grain, [&](std::size_t first, std::size_t last) {
+        for (auto i = first; i < last; ++i) {
+            auto& primitive = primitives[i];
+            if (primitive.count < 3) {
+                continue;
+            }
+            auto* points = vertices.data() + primitive.first;
+            double low_x = kInfinity;
+            double low_y = kInfinity;
+            double high_x = -kInfinity;
+            double high_y = -kInfinity;
+            bool finite = true;
+            for (std::size_t k = 0; k < primitive.count; ++k) {
+                points[k] = Point<double>{(points[k].x() - center_x) / scale + static_cast<double>(width) / 2.0,
+                                          static_cast<double>(height) / 2.0 - (points[k].y() - center_y) / scale};
+                low_x = std::min(low_x, points[k].x());
+                low_y = std::min(low_y, points[k].y());
+                high_x = std::max(high_x, points[k].x());
+                high_y = std::max(high_y, points[k].y());
+                finite = finite && std::isfinite(points[k].x()) && std::isfinite(points[k].y());
+            }
+            if (!finite || high_x < 0.0 || high_y < 0.0 || low_x > static_cast<double>(width) ||
+                low_y > static_cast<double>(height)) {
+                continue;
+            }
+            primitive.min_x = std::max<std::ptrdiff_t>(0, first_center(low_x));
+            primitive.min_y = std::max<std::ptrdiff_t>(0, first_center(low_y));
+            primitive.max_x = std::min(width - 1, last_center(high_x));
+            primitive.max_y = std::min(height - 1, last_center(high_y));
+            if (first_center(low_x) > last_center(high_x) || first_center(low_y) > last_center(high_y)) {
+                const auto x = static_cast<std::ptrdiff_t>(std::floor(points[0].x()));
+                const auto y = static_cast<std::ptrdiff_t>(std::floor(points[0].y()));
+                primitive.splat = x >= 0 && x < width && y >= 0 && y < height;
+                primitive.min_x = primitive.max_x = x;
+                primitive.min_y = primitive.max_y = y;
+                if (!primitive.splat) {
+                    primitive.max_x = primitive.min_x - 1;
+                }
+                continue;
+            }
+            primitive.convex = primitive.count <= 3 ||
+                               convex_orientation(std::span<const Point<double>>{points, primitive.count}) != 0;
+            primitive.side = area_sign(points, primitive.count);
+        }
+    });
+    if (stop.stop_requested()) {
+        return std::nullopt;
+    }
+
+    const auto tile = static_cast<std::ptrdiff_t>(options.tile_size);
+    const auto tiles_x = (width + tile - 1) / tile;
+    const auto tiles_y = (height + tile - 1) / tile;
+    const auto tile_count = static_cast<std::size_t>(tiles_x * tiles_y);
+    const auto for_each_tile = [&](const ScreenPrimitive& primitive, auto&& visit) {
+        if (primitive.min_x > primitive.max_x || primitive.min_y > primitive.max_y) {
+            return;
+        }
+        for (auto ty = primitive.min_y / tile; ty <= primitive.max_y / tile; ++ty) {
+            for (auto tx = primitive.min_x / tile; tx <= primitive.max_x / tile; ++tx) {
+                visit(static_cast<std::size_t>(ty * tiles_x + tx));
+            }
+        }
+    };
+    // Each tile gets its own contiguous copy of its primitives and their
+    // vertices, so filling a tile streams through memory instead of chasing
+    // indices across the whole collection.
+    std::vector<std::size_t> tile_start(tile_count + 1, 0);
+    std::vector<std::size_t> tile_vertex_start(tile_count + 1, 0);
+    for (const auto& primitive : primitives) {
+        for_each_tile(primitive, [&](std::size_t t) {
+            ++tile_start[t + 1];
+            tile_vertex_start[t + 1] += primitive.splat ? 0 : primitive.count;
+        });
+    }
+    for (std::size_t t = 1; t <= tile_count; ++t) {
+        tile_start[t] += tile_start[t - 1];
+        tile_vertex_start[t] += tile_vertex_start[t - 1];
+    }
+    std::vector<ScreenPrimitive> binned(tile_start.back());
+    std::vector<Point<double>> binned_vertices(tile_vertex_start.back());
+    {
+        auto cursor = tile_start;
+        auto vertex_cursor = tile_vertex_start;
+        for (const auto& primitive : primitives) {
+            for_each_tile(primitive, [&](std::size_t t) {
+                auto& entry = binned[cursor[t]++];
+                entry = primitive;
+                if (!primitive.splat) {
+                    entry.first = vertex_cursor[t];
+                    std::copy_n(vertices.begin() + static_cast<std::ptrdiff_t>(primitive.first), primitive.count,
+                                binned_vertices.begin() + static_cast<std::ptrdiff_t>(entry.first));
+                    vertex_cursor[t] += primitive.count;
+                }
+            });
+        }
+    }
+
+    // One tile per chunk: their cost varies too much to split the range
+    // evenly up front.
+    run_chunks(pool, tile_count, 1, [&](std::size_t first, std::size_t last) {
+        std::vector<EdgeBound> edges;
+        std::vector<double> crossings;
+        for (auto t = first; t < last && !stop.stop_requested(); ++t) {
+            const auto tile_x = static_cast<std::ptrdiff_t>(t) % tiles_x * tile;
+            const auto tile_y = static_cast<std::ptrdiff_t>(t) / tiles_x * tile;
+            for (auto b = tile_start[t]; b < tile_start[t + 1]; ++b) {
+                const auto& primitive = binned[b];
+                if (primitive.splat) {
+                    ++grid.row(static_cast<std::size_t>(primitive.min_y))[primitive.min_x];
+                    continue;
+                }
+                const auto min_x = std::max(primitive.min_x, tile_x);
+                const auto min_y = std::max(primitive.min_y, tile_y);
+                const auto max_x = std::min(primitive.max_x, std::min(tile_x + tile, width) - 1);
+                const auto max_y = std::min(primitive.max_y, std::min(tile_y + tile, height) - 1);
+                const auto* points = binned_vertices.data() + primitive.first;
+                if (primitive.convex) {
+                    fill_convex(grid, points, primitive.count, primitive.side, min_x, min_y, max_x, max_y,
+                                edges);
+                } else {
+                    fill_crossings(grid, points, primitive.count, min_x, min_y, max_x, max_y, crossings);
+                }
+            }
+        }
+    });
+    if (stop.stop_requested()) {
+        return std::nullopt;
+    }
+    return grid;
+}
+
+}  // namespace detail
+
+// Renders the collection into a coverage grid. Figures are first converted
+// to pixel coordinates in parallel and binned by bounding box into square
+// tiles; each task then takes a whole tile and fills the figures binned
+// there, clipped to the tile, so no two threads touch the same pixel.
+// Triangles, rectangles and convex polygons are filled by edge functions,
+// other polygons by even-odd scanline crossings. The viewport keeps the
+// aspect ratio and is centered in the image. Empty slots and figures with a
+// non-finite vertex are skipped.
+//
+// This overload runs the phases as tasks on `pool`, ignoring
+// options.thread_count, and returns std::nullopt once `stop` was requested.
+template <Scalar T, typename Growth>
+std::optional<CoverageGrid> rasterize(const Array<std::shared_ptr<Figure<T>>, Growth>& figures,
+                                      const RasterOptions& options, ThreadPool& pool, std::stop_token stop = {}) {
+    return detail::rasterize_on(figures, options, &pool, stop);
+}
+
+// Renders on the calling thread, or with thread_count > 1 (0 means hardware
+// concurrency) on a pool of that many threads made for the call.
+template <Scalar T, typename Growth>
+CoverageGrid rasterize(const Array<std::shared_ptr<Figure<T>>, Growth>& figures, const RasterOptions& options = {}) {
+    if (options.thread_count == 1) {
+        return *detail::rasterize_on(figures, options, nullptr, {});
+    }
+    ThreadPool pool{options.thread_count};
+    return *detail::rasterize_on(figures, options, &pool, {});
+}
+
+
+namespace detail {
+
+// Coverage mapped to [0, 1] on a logarithmic scale so that a few dense
+// spots do not wash out the rest of the image.
+inline std::vector<double> coverage_levels(const CoverageGrid& grid) {
+    const auto top = std::log1p(static_cast<double>(grid.max()));
+    std::vector<double> levels;
+    levels.reserve(grid.width() * grid.height());
+    for (std::size_t y = 0; y < grid.height(); ++y) {
+        const auto* row = grid.row(y);
+        for (std::size_t x = 0; x < grid.width(); ++x) {
+            levels.push_back(top > 0.0 ? std::log1p(static_cast<double>(row[x])) / top : 0.0);
+        }
+    }
+    return levels;
+}
+
+inline void write_image(std::ostream& out, const char* magic, const CoverageGrid& grid,
+                        const std::vector<unsigned char>& pixels) {
+    out << magic << '\n' << grid.width() << ' ' << grid.height() << "\n255\n";
+    out.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    if (!out) {
+        throw std::runtime_error("cannot write image");
+    }
+}
+
+}  // namespace detail
+
+// Binary PGM: white background, darker where more figures overlap.
+inline void write_pgm(std::ostream& out, const CoverageGrid& grid) {
+    std::vector<unsigned char> pixels;
+    pixels.reserve(grid.width() * grid.height());
+    for (const auto level : detail::coverage_levels(grid)) {
+        pixels.push_back(static_cast<unsigned char>(std::lround(255.0 * (1.0 - level))));
+    }
+    detail::write_image(out, "P5", grid, pixels);
+}
+
+// Binary PPM: white background, then from light blue for single coverage to
+// dark red at the densest pixel.
+inline void write_ppm(std::ostream& out, const CoverageGrid& grid) {
+    constexpr double kLow[3] = {170.0, 200.0, 240.0};
+    constexpr double kHigh[3] = {140.0, 0.0, 20.0};
+    std::vector<unsigned char> pixels;
+    pixels.reserve(3 * grid.width() * grid.height());
+    for (const auto level : detail::coverage_levels(grid)) {
+        for (std::size_t c = 0; c < 3; ++c) {
+            const auto value = level > 0.0 ? kLow[c] + (kHigh[c] - kLow[c]) * level : 255.0;
+            pixels.push_back(static_cast<unsigned char>(std::lround(value)));
+        }
+    }
+    detail::write_image(out, "P6", grid, pixels);
+}
+
+}  // namespace lab04
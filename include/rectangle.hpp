@@ -5,13 +5,13 @@
 #include <stdexcept>
 #include <type_traits>
 
-#include "polygon.hpp"
+#include "axis_aligned.hpp"
 
 namespace lab04 {
 
 template <Scalar T>
-class Rectangle : public PolygonFigure<Rectangle<T>, T, 4> {
-    using base_type = PolygonFigure<Rectangle<T>, T, 4>;
+class Rectangle : public AxisAlignedFigure<Rectangle<T>, T> {
+    using base_type = AxisAlignedFigure<Rectangle<T>, T>;
     using point_type = typename base_type::point_type;
 
 public:
@@ -21,17 +21,18 @@ public:
         if (width <= static_cast<T>(0) || height <= static_cast<T>(0)) {
             throw std::invalid_argument("rectangle sides must be positive");
         }
-        using real = std::common_type_t<T, double>;
-        const auto half_width = static_cast<real>(width) / static_cast<real>(2);
-        const auto half_height = static_cast<real>(height) / static_cast<real>(2);
-        const auto cx = static_cast<real>(center.x());
-        const auto cy = static_cast<real>(center.y());
-        std::array<point_type, 4> points{
-            point_type{static_cast<T>(cx - half_width), static_cast<T>(cy - half_height)},
-            point_type{static_cast<T>(cx + half_width), static_cast<T>(cy - half_height)},
-            point_type{static_cast<T>(cx + half_width), static_cast<T>(cy + half_height)},
-            point_type{static_cast<T>(cx - half_width), static_cast<T>(cy + half_height)}};
-        this->assign(points);
+        this->assign_centered(center, width, height);
+    }
+
+    // Rebuilds a rectangle from vertices in the order produced by the center
+    // constructor; used when restoring persisted figures bit-for-bit.
+    [[nodiscard]] static Rectangle from_vertices(const std::array<point_type, 4>& points) {
+        if (!base_type::is_axis_aligned(points)) {
+            throw std::invalid_argument("vertices do not form an axis-aligned rectangle");
+        }
+        Rectangle rectangle;
+        rectangle.assign_bounds(points[0].x(), points[0].y(), points[2].x(), points[2].y());
+        return rectangle;
     }
 
     Rectangle(const Rectangle&) = default;
@@ -40,29 +41,15 @@ public:
     Rectangle& operator=(Rectangle&&) noexcept = default;
     ~Rectangle() override = default;
 
-    [[nodiscard]] std::unique_ptr<Figure<T>> clone() const override {
-        return std::make_unique<Rectangle>(*this);
-    }
-
     [[nodiscard]] const char* shape_name() const { return "Rectangle"; }
 
     [[nodiscard]] double diagonal() const {
-        const auto vertices = this->vertices();
-        using real = std::common_type_t<T, double>;
-        const auto dx = static_cast<real>(vertices[2].x()) - static_cast<real>(vertices[0].x());
-        const auto dy = static_cast<real>(vertices[2].y()) - static_cast<real>(vertices[0].y());
-        return std::sqrt(dx * dx + dy * dy);
+        return std::hypot(this->width(), this->height());
     }
 
     [[nodiscard]] double circumscribed_circle_radius() const {
         return diagonal() / 2.0;
     }
-
-private:
-    [[nodiscard]] bool is_equal(const Figure<T>& other) const override {
-        return base_type::is_equal(other);
-    }
 };
 
 }  // namespace lab04
-
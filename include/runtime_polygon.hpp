@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "polygon.hpp"
+
+namespace lab04 {
+
+// Polygon with any number of vertices kept in one contiguous buffer. Unlike
+// PolygonFigure the vertex count is a runtime property, so inputs with
+// thousands of vertices cost one allocation instead of one per vertex. The
+// outline is not checked for simplicity: a self-intersecting one is allowed,
+// contains() applies the even-odd rule to it and area() is the absolute
+// shoelace sum, in which loops of opposite orientation cancel.
+template <Scalar T>
+class Polygon : public Figure<T> {
+public:
+    using point_type = Point<T>;
+
+    Polygon() = default;
+
+    explicit Polygon(std::pmr::vector<point_type> points) : vertices_(std::move(points)) {
+        if (vertices_.size() < 3) {
+            throw std::invalid_argument("polygon needs at least three vertices");
+        }
+        if (area() == 0.0) {
+            throw std::invalid_argument("polygon must have non-zero area");
+        }
+    }
+
+    explicit Polygon(const std::vector<point_type>& points)
+        : Polygon(std::pmr::vector<point_type>(points.begin(), points.end())) {}
+
+    Polygon(std::initializer_list<point_type> points) : Polygon(std::pmr::vector<point_type>(points)) {}
+
+    Polygon(const Polygon&) = default;
+    Polygon& operator=(const Polygon&) = default;
+    // A polymorphic allocator travels with a moved vector, so a polygon copied
+    // into a snapshot arena would keep pointing there; moving re-homes its
+    // vertices to the default resource instead, copying when that differs.
+    Polygon(Polygon&& other) : vertices_(std::move(other.vertices_), std::pmr::get_default_resource()) {}
+    Polygon& operator=(Polygon&&) = default;
+    ~Polygon() override = default;
+
+    [[nodiscard]] point_type center() const override {
+        using real = std::common_type_t<T, double>;
+        const auto* p = vertices_.data();
+        const auto count = vertices_.size();
+        if (count == 0) {
+            return point_type{};
+        }
+        real sx[4]{};
+        real sy[4]{};
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            for (std::size_t k = 0; k < 4; ++k) {
+                sx[k] += static_cast<real>(p[i + k].x());
+                sy[k] += static_cast<real>(p[i + k].y());
+            }
+        }
+        for (; i < count; ++i) {
+            sx[0] += static_cast<real>(p[i].x());
+            sy[0] += static_cast<real>(p[i].y());
+        }
+        const auto n = static_cast<real>(count);
+        return point_type{static_cast<T>((sx[0] + sx[1] + sx[2] + sx[3]) / n),
+                          static_cast<T>((sy[0] + sy[1] + sy[2] + sy[3]) / n)};
+    }
+
+    // Shoelace formula relative to the first vertex: the shift keeps the
+    // products small for far-away polygons and removes the two terms that
+    // touch vertex 0. Four independent accumulators let the loop vectorize.
+    [[nodiscard]] double area() const override {
+        LAB04_TRACE_SCOPE("Polygon::area");
+        const auto count = vertices_.size();
+        if (count < 3) {
+            return 0.0;
+        }
+        using real = std::common_type_t<T, double>;
+        const auto* p = vertices_.data();
+        const auto ox = static_cast<real>(p[0].x());
+        const auto oy = static_cast<real>(p[0].y());
+        real sum[4]{};
+        std::size_t i = 1;
+        for (; i + 4 < count; i += 4) {
+            for (std::size_t k = 0; k < 4; ++k) {
+                const auto ax = static_cast<real>(p[i + k].x()) - ox;
+                const auto ay = static_cast<real>(p[i + k].y()) - oy;
+                const auto bx = static_cast<real>(p[i + k + 1].x()) - ox;
+                const auto by = static_cast<real>(p[i + k + 1].y()) - oy;
+                sum[k] += ax * by - ay * bx;
+            }
+        }
+        for (; i + 1 < count; ++i) {
+            const auto ax = static_cast<real>(p[i].x()) - ox;
+            const auto ay = static_cast<real>(p[i].y()) - oy;
+            const auto bx = static_cast<real>(p[i + 1].x()) - ox;
+            const auto by = static_cast<real>(p[i + 1].y()) - oy;
+            sum[0] += ax * by - ay * bx;
+        }
+        return std::fabs(static_cast<double>((sum[0] + sum[1]) + (sum[2] + sum[3])) * 0.5);
+    }
+
+    void print(std::ostream& os) const override {
+        const auto previous_flags = os.flags();
+        const auto previous_precision = os.precision();
+
+        os << shape_name() << ": ";
+        os << "vertices=[";
+        for (std::size_t i = 0; i < vertices_.size(); ++i) {
+            os << vertices_[i];
+            if (i + 1 < vertices_.size()) {
+                os << ", ";
+            }
+        }
+        os << "], center=" << center() << ", area=" << std::fixed << std::setprecision(3) << area();
+
+        os.flags(previous_flags);
+        os.precision(previous_precision);
+    }
+
+    [[nodiscard]] std::unique_ptr<Figure<T>> clone() const override {
+        LAB04_TRACE_SCOPE("Polygon::clone");
+        return std::make_unique<Polygon>(*this);
+    }
+
+    [[nodiscard]] std::size_t snapshot_footprint() const override {
+        return arena_footprint<Polygon>() + arena_footprint<point_type>(vertices_.size());
+    }
+
+    [[nodiscard]] Figure<T>* clone_into(std::pmr::memory_resource& resource) const override {
+        void* memory = resource.allocate(sizeof(Polygon), alignof(Polygon));
+        return ::new (memory) Polygon(*this, &resource);
+    }
+
+    [[nodiscard]] std::size_t vertex_count() const override { return vertices_.size(); }
+
+    [[nodiscard]] point_type vertex(std::size_t index) const override {
+        if (index >= vertices_.size()) {
+            throw std::out_of_range("vertex index out of range");
+        }
+        return vertices_[index];
+    }
+
+    // Even-odd rule; points on the outline count as inside.
+    [[nodiscard]] bool contains(const point_type& point) const override {
+        using real = std::common_type_t<T, double>;
+        const auto px = static_cast<real>(point.x());
+        const auto py = static_cast<real>(point.y());
+        bool inside = false;
+        const auto count = vertices_.size();
+        for (std::size_t i = 0, j = count - 1; i < count; j = i++) {
+            const auto ax = static_cast<real>(vertices_[j].x());
+            const auto ay = static_cast<real>(vertices_[j].y());
+            const auto bx = static_cast<real>(vertices_[i].x());
+            const auto by = static_cast<real>(vertices_[i].y());
+
+            const auto lhs = (bx - ax) * (py - ay);
+            const auto rhs = (by - ay) * (px - ax);
+            const auto tolerance =
+                std::numeric_limits<real>::epsilon() * 16 * (std::fabs(lhs) + std::fabs(rhs));
+            if (std::fabs(lhs - rhs) <= tolerance && px >= std::min(ax, bx) && px <= std::max(ax, bx) &&
+                py >= std::min(ay, by) && py <= std::max(ay, by)) {
+                return true;
+            }
+            if ((ay > py) != (by > py) && px < ax + (bx - ax) * (py - ay) / (by - ay)) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    [[nodiscard]] const char* shape_name() const { return "Polygon"; }
+
+    [[nodiscard]] std::span<const point_type> vertices() const noexcept { return vertices_; }
+
+    // Counter-clockwise convex hull without collinear vertices.
+    [[nodiscard]] Polygon convex_hull() const {
+        if (vertices_.size() < 3) {
+            return *this;
+        }
+        std::vector<point_type> points(vertices_.begin(), vertices_.end());
+        return Polygon{detail::monotone_chain(points)};
+    }
+
+    // Ramer-Douglas-Peucker on the closed outline: drops vertices closer
+    // than `tolerance` to the simplified outline. Returns an unchanged copy
+    // if simplification would collapse the polygon.
+    [[nodiscard]] Polygon simplified(double tolerance) const {
+        const auto count = vertices_.size();
+        if (count <= 3) {
+            return *this;
+        }
+        std::size_t far = 0;
+        double far_distance = -1.0;
+        for (std::size_t i = 1; i < count; ++i) {
+            const auto dx = static_cast<double>(vertices_[i].x()) - static_cast<double>(vertices_[0].x());
+            const auto dy = static_cast<double>(vertices_[i].y()) - static_cast<double>(vertices_[0].y());
+            const auto distance = dx * dx + dy * dy;
+            if (distance > far_distance) {
+                far_distance = distance;
+                far = i;
+            }
+        }
+
+        std::vector<bool> keep(count + 1, false);
+        keep[0] = keep[far] = keep[count] = true;
+        std::vector<std::pair<std::size_t, std::size_t>> ranges{{0, far}, {far, count}};
+        while (!ranges.empty()) {
+            const auto [first, last] = ranges.back();
+            ranges.pop_back();
+            std::size_t split = first;
+            double worst = tolerance;
+            for (auto i = first + 1; i < last; ++i) {
+                const auto distance = segment_distance(vertices_[i], at(first), at(last));
+                if (distance > worst) {
+                    worst = distance;
+                    split = i;
+                }
+            }
+            if (split != first) {
+                keep[split] = true;
+                ranges.emplace_back(first, split);
+                ranges.emplace_back(split, last);
+            }
+        }
+
+        std::pmr::vector<point_type> result;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (keep[i]) {
+                result.push_back(vertices_[i]);
+            }
+        }
+        if (result.size() < 3) {
+            return *this;
+        }
+        return Polygon{std::move(result)};
+    }
+
+protected:
+    [[nodiscard]] bool is_equal(const Figure<T>& other) const override {
+        const auto* other_ptr = dynamic_cast<const Polygon*>(&other);
+        return other_ptr && almost_equal<T>(std::span<const point_type>{vertices_},
+                                            std::span<const point_type>{other_ptr->vertices_});
+    }
+
+private:
+    std::pmr::vector<point_type> vertices_;
+
+    // Copy whose vertex buffer comes from `resource`; used by clone_into().
+    Polygon(const Polygon& other, std::pmr::memory_resource* resource) : vertices_(other.vertices_, resource) {}
+
+    [[nodiscard]] const point_type& at(std::size_t index) const {
+        return vertices_[index % vertices_.size()];
+    }
+
+    [[nodiscard]] static double segment_distance(const point_type& p, const point_type& a, const point_type& b) {
+        const auto abx = static_cast<double>(b.x()) - static_cast<double>(a.x());
+        const auto aby = static_cast<double>(b.y()) - static_cast<double>(a.y());
+        const auto apx = static_cast<double>(p.x()) - static_cast<double>(a.x());
+        const auto apy = static_cast<double>(p.y()) - static_cast<double>(a.y());
+        const auto length_sq = abx * abx + aby * aby;
+        if (length_sq == 0.0) {
+            return std::hypot(apx, apy);
+        }
+        const auto t = std::clamp((apx * abx + apy * aby) / length_sq, 0.0, 1.0);
+        return std::hypot(apx - t * abx, apy - t * aby);
+    }
+};
+
+}  // namespace lab04
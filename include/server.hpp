@@ -0,0 +1,663 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "array.hpp"
+#include "figure_views.hpp"
+#include "hit_test.hpp"
+#include "ingest.hpp"
+#include "journal.hpp"
+#include "task_executor.hpp"
+#include "union_area.hpp"
+
+namespace lab04 {
+
+// Line protocol: every request is one line and gets exactly one response
+// line, in request order, so clients may pipeline any number of requests.
+//
+//   ADD <figure>     -> OK <index>      (figure as in ingest_figures)
+//   ERASE <index>    -> OK <size>
+//   QUERY <x> <y>    -> OK <count> <index>...
+//   AREA             -> OK <sum of areas>
+//   UNION            -> OK <covered area>
+//   SIZE             -> OK <size>
+//
+// Failures answer "ERR <message>"; blank lines are ignored.
+template <Scalar T>
+class FigureService {
+public:
+    using collection_type = Array<std::shared_ptr<Figure<T>>>;
+    // Writes the reply to a request whose work was moved off the calling
+    // thread; it only uses data captured when the request was read.
+    using Deferred = std::function<void(std::string&)>;
+
+    explicit FigureService(collection_type& figures, FigureJournal<T>* journal = nullptr)
+        : figures_(figures), journal_(journal) {
+        for (const double area : figures_ | views::areas) {
+            add_area(area);
+        }
+    }
+
+    void process_line(std::string_view line, std::string& out) {
+        LAB04_TRACE_SCOPE("FigureService::process_line");
+        const auto request = split(line);
+        if (!request) {
+            return;
+        }
+        const auto [command, arguments] = *request;
+
+        try {
+            if (command == "ADD") {
+                add(arguments, out);
+            } else if (command == "ERASE") {
+                erase(arguments, out);
+            } else if (command == "QUERY") {
+                query(arguments, out);
+            } else if (command == "AREA") {
+                reply(out, figures_.empty() ? 0.0 : area_total_ + area_error_);
+            } else if (command == "UNION") {
+                reply(out, union_area(figures_));
+            } else if (command == "SIZE") {
+                reply(out, figures_.size());
+            } else {
+                error(out, "unknown command '" + std::string{command} + "'");
+            }
+        } catch (const std::exception& ex) {
+            error(out, ex.what());
+        }
+    }
+
+    // The deferred form of an expensive read-only request (UNION) over a
+    // copy of the collection as it is now; an empty function for any other
+    // line, which process_line() should answer instead.
+    [[nodiscard]] Deferred defer(std::string_view line) const {
+        const auto request = split(line);
+        if (!request || request->first != "UNION") {
+            return {};
+        }
+        return [snapshot = figures_](std::string& out) {
+            try {
+                reply(out, union_area(snapshot));
+            } catch (const std::exception& ex) {
+                error(out, ex.what());
+            }
+        };
+    }
+
+    // Called after each batch of pipelined requests, so the journal pays
+    // for one fsync per batch rather than one per request.
+    void flush() {
+        if (journal_) {
+            journal_->commit();
+            journal_->maybe_snapshot(figures_);
+        }
+    }
+
+private:
+    collection_type& figures_;
+    FigureJournal<T>* journal_;
+    // Built by the first QUERY and kept up to date by ADD and ERASE.
+    std::optional<HitTestIndex<T>> index_;
+    // Running sum of the areas with a Neumaier compensation term, so that
+    // erasing a figure cancels its addition without drift.
+    double area_total_{0.0};
+    double area_error_{0.0};
+
+    void add_area(double area) {
+        const auto sum = area_total_ + area;
+        area_error_ += std::fabs(area_total_) >= std::fabs(area) ? (area_total_ - sum) + area
+                                                                 : (area - sum) + area_total_;
+        area_total_ = sum;
+    }
+
+    void add(std::string_view arguments, std::string& out) {
+        FigureSpec<T> spec;
+        std::string message;
+        if (!detail::parse_figure_line(std::string{arguments}, 0, spec, message)) {
+            error(out, message);
+            return;
+        }
+        figures_.push_back(detail::construct_figure(spec));
+        add_area(figures_.back()->area());
+        if (index_) {
+            index_->push_back(figures_.back());
+        }
+        if (journal_) {
+            journal_->record_add(*figures_.back());
+        }
+        reply(out, figures_.size() - 1);
+    }
+
+    void erase(std::string_view arguments, std::string& out) {
+        std::size_t index = 0;
+        if (!parse_all(arguments, index)) {
+            error(out, "usage: ERASE <index>");
+            return;
+        }
+        const auto area = index < figures_.size() && figures_[index] ? figures_[index]->area() : 0.0;
+        figures_.erase(index);
+        add_area(-area);
+        if (index_) {
+            index_->erase(index);
+        }
+        if (journal_) {
+            journal_->record_erase(index);
+        }
+        reply(out, figures_.size());
+    }
+
+    void query(std::string_view arguments, std::string& out) {
+        T x{};
+        T y{};
+        if (!parse_all(arguments, x, y)) {
+            error(out, "usage: QUERY <x> <y>");
+            return;
+        }
+        if (!index_) {
+            index_.emplace(figures_);
+        }
+        SmallArray<std::size_t, 16> hits;
+        index_->query(Point<T>{x, y}, hits);
+        out += "OK ";
+        append_number(out, hits.size());
+        for (const auto hit : hits) {
+            out += ' ';
+            append_number(out, hit);
+        }
+        out += '\n';
+    }
+
+    // Command and arguments of a request line; nothing for a blank one.
+    static std::optional<std::pair<std::string_view, std::string_view>> split(std::string_view line) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        const auto start = line.find_first_not_of(' ');
+        if (start == std::string_view::npos) {
+            return std::nullopt;
+        }
+        line.remove_prefix(start);
+        const auto command = line.substr(0, line.find(' '));
+        return std::pair{command, line.substr(command.size())};
+    }
+
+    template <typename... Values>
+    static bool parse_all(std::string_view text, Values&... values) {
+        std::istringstream in{std::string{text}};
+        std::string rest;
+        return (static_cast<bool>(in >> values) && ...) && !(in >> rest);
+    }
+
+    template <typename Number>
+    static void append_number(std::string& out, Number value) {
+        char buffer[64];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    template <typename Number>
+    static void reply(std::string& out, Number value) {
+        out += "OK ";
+        append_number(out, value);
+        out += '\n';
+    }
+
+    static void error(std::string& out, std::string_view message) {
+        out += "ERR ";
+        for (const char c : message) {
+            out += c == '\n' ? ' ' : c;
+        }
+        out += '\n';
+    }
+};
+
+struct ServerOptions {
+    std::size_t max_line_length{64 * 1024};
+    // A connection stops being read while this much output is unsent.
+    std::size_t max_pending_output{1 << 20};
+    int backlog{128};
+};
+
+// Single-threaded epoll loop serving FigureService over a Unix socket (any
+// endpoint containing '/') or loopback TCP ("127.0.0.1:7000", port 0 picks a
+// free one). Each readable event reads the socket, answers every complete
+// line and writes the replies back in one go; a partial line longer than
+// max_line_length closes the connection. Given a pool, requests the service
+// can defer run there instead of stalling the loop: their connection pauses
+// until the reply is in, so replies keep request order, while other clients
+// are served meanwhile. stop() may be called from another thread or a
+// signal handler.
+template <Scalar T>
+class FigureServer {
+public:
+    FigureServer(FigureService<T>& service, std::string endpoint, ServerOptions options = {},
+                 ThreadPool* pool = nullptr)
+        : service_(service), endpoint_(std::move(endpoint)), options_(options), pool_(pool),
+          completions_(std::make_shared<Completions>()) {
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        stop_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        completions_->fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_fd_ < 0 || stop_fd_ < 0 || completions_->fd < 0) {
+            const int saved = errno;
+            close_all();
+            errno = saved;
+            detail::throw_errno("cannot create server event loop");
+        }
+        try {
+            listen_fd_ = endpoint_.find('/') != std::string::npos ? listen_unix() : listen_tcp();
+            watch(stop_fd_, EPOLLIN);
+            watch(completions_->fd, EPOLLIN);
+            watch(listen_fd_, EPOLLIN);
+        } catch (...) {
+            close_all();
+            throw;
+        }
+    }
+
+    FigureServer(const FigureServer&) = delete;
+    FigureServer& operator=(const FigureServer&) = delete;
+
+    ~FigureServer() { close_all(); }
+
+    [[nodiscard]] const std::string& endpoint() const noexcept { return endpoint_; }
+    [[nodiscard]] std::uint16_t port() const noexcept { return port_; }
+
+    void stop() noexcept {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const auto ignored = ::write(stop_fd_, &one, sizeof(one));
+    }
+
+    // Serves clients until stop() is called.
+    void run() {
+        epoll_event events[64];
+        while (true) {
+            const int count = ::epoll_wait(epoll_fd_, events, 64, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                detail::throw_errno("epoll_wait failed");
+            }
+            for (int i = 0; i < count; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == stop_fd_) {
+                    std::uint64_t value = 0;
+                    [[maybe_unused]] const auto ignored = ::read(stop_fd_, &value, sizeof(value));
+                    return;
+                }
+                if (fd == listen_fd_) {
+                    accept_clients();
+                    continue;
+                }
+                if (fd == completions_->fd) {
+                    finish_deferred();
+                    continue;
+                }
+                const auto it = connections_.find(fd);
+                if (it == connections_.end()) {
+                    continue;
+                }
+                if (it->second.waiting && (events[i].events & (EPOLLHUP | EPOLLERR))) {
+                    // Gone while its deferred reply is computed; the reply is dropped.
+                    drop(fd);
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    read_client(it->second);
+                }
+                if (events[i].events & EPOLLOUT) {
+                    write_client(it->second);
+                }
+                settle(it->second);
+            }
+        }
+    }
+
+private:
+    struct Connection {
+        int fd{-1};
+        // Distinguishes connections that reuse a descriptor.
+        std::uint64_t id{0};
+        std::string in;
+        std::string out;
+        std::size_t sent{0};
+        std::uint32_t interest{0};
+        bool closing{false};
+        // A deferred request is running; later lines wait for its reply.
+        bool waiting{false};
+    };
+
+    struct Completion {
+        int fd;
+        std::uint64_t id;
+        std::string reply;
+    };
+
+    // Shared with the pool jobs, so a job finishing after the server is gone
+    // still has somewhere to report to.
+    struct Completions {
+        int fd{-1};
+        std::mutex mutex;
+        std::vector<Completion> done;
+
+        ~Completions() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    };
+
+    FigureService<T>& service_;
+    std::string endpoint_;
+    ServerOptions options_;
+    ThreadPool* pool_;
+    std::shared_ptr<Completions> completions_;
+    std::uint64_t next_id_{0};
+    int epoll_fd_{-1};
+    int stop_fd_{-1};
+    int listen_fd_{-1};
+    bool unix_socket_{false};
+    std::uint16_t port_{0};
+    std::unordered_map<int, Connection> connections_;
+
+    int listen_unix() {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (endpoint_.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("socket path is too long");
+        }
+        std::memcpy(address.sun_path, endpoint_.c_str(), endpoint_.size() + 1);
+
+        // A stale socket from a previous run would make bind() fail; only
+        // remove the path if it really is a socket.
+        struct stat status {};
+        if (::stat(endpoint_.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+            ::unlink(endpoint_.c_str());
+        }
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            detail::throw_errno("cannot create socket");
+        }
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(fd, options_.backlog) != 0) {
+            const int saved = errno;
+            ::close(fd);
+            errno = saved;
+            detail::throw_errno("cannot listen on " + endpoint_);
+        }
+        unix_socket_ = true;
+        return fd;
+    }
+
+    int listen_tcp() {
+        const auto colon = endpoint_.rfind(':');
+        if (colon == std::string::npos) {
+            throw std::invalid_argument("endpoint must be a socket path or host:port");
+        }
+        const auto host = endpoint_.substr(0, colon);
+        if (host != "127.0.0.1" && host != "localhost") {
+            throw std::invalid_argument("server only listens on loopback addresses");
+        }
+        unsigned port = 0;
+        const auto port_text = std::string_view{endpoint_}.substr(colon + 1);
+        const auto [end, ec] = std::from_chars(port_text.data(), port_text.data() + port_text.size(), port);
+        if (ec != std::errc{} || end != port_text.data() + port_text.size() || port > 65535) {
+            throw std::invalid_argument("invalid port '" + std::string{port_text} + "'");
+        }
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            detail::throw_errno("cannot create socket");
+        }
+        const int enable = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        socklen_t length = sizeof(address);
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(fd, options_.backlog) != 0 ||
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            const int saved = errno;
+            ::close(fd);
+            errno = saved;
+            detail::throw_errno("cannot listen on " + endpoint_);
+        }
+        port_ = ntohs(address.sin_port);
+        return fd;
+    }
+
+    void watch(int fd, std::uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            detail::throw_errno("cannot register descriptor with epoll");
+        }
+    }
+
+    void accept_clients() {
+        while (true) {
+            const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            if (!unix_socket_) {
+                const int enable = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            }
+            try {
+                watch(fd, EPOLLIN);
+            } catch (const std::system_error&) {
+                ::close(fd);
+                continue;
+            }
+            Connection connection;
+            connection.fd = fd;
+            connection.id = ++next_id_;
+            connection.interest = EPOLLIN;
+            connections_[fd] = std::move(connection);
+        }
+    }
+
+    // Answers the buffered lines, then reads more, one chunk at a time so that
+    // the input never holds more than a chunk beyond the longest allowed
+    // line. Stops at end of input, at a deferred request, or once enough
+    // output is pending; the interest mask resumes reading later.
+    void read_client(Connection& connection) {
+        char buffer[64 * 1024];
+        answer_lines(connection);
+        while (!connection.closing && !connection.waiting &&
+               connection.out.size() - connection.sent < options_.max_pending_output) {
+            const auto count = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (count > 0) {
+                connection.in.append(buffer, static_cast<std::size_t>(count));
+                answer_lines(connection);
+                continue;
+            }
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            connection.closing = true;
+        }
+        write_client(connection);
+    }
+
+    void answer_lines(Connection& connection) {
+        std::size_t consumed = 0;
+        while (!connection.waiting) {
+            const auto newline = connection.in.find('\n', consumed);
+            if (newline == std::string::npos) {
+                break;
+            }
+            const auto line = std::string_view{connection.in}.substr(consumed, newline - consumed);
+            auto deferred = pool_ ? service_.defer(line) : typename FigureService<T>::Deferred{};
+            if (!deferred || !start_deferred(connection, std::move(deferred))) {
+                service_.process_line(line, connection.out);
+            }
+            consumed = newline + 1;
+        }
+        connection.in.erase(0, consumed);
+        if (consumed > 0) {
+            service_.flush();
+        }
+        if (!connection.waiting && connection.in.size() > options_.max_line_length) {
+            connection.out += "ERR request line too long\n";
+            connection.in.clear();
+            connection.closing = true;
+        }
+    }
+
+    // Hands the request to the pool; false if it could not be queued.
+    bool start_deferred(Connection& connection, typename FigureService<T>::Deferred deferred) {
+        try {
+            pool_->submit([completions = completions_, fd = connection.fd, id = connection.id,
+                           deferred = std::move(deferred)] {
+                Completion completion{fd, id, {}};
+                deferred(completion.reply);
+                {
+                    std::lock_guard lock{completions->mutex};
+                    completions->done.push_back(std::move(completion));
+                }
+                const std::uint64_t one = 1;
+                [[maybe_unused]] const auto ignored = ::write(completions->fd, &one, sizeof(one));
+            });
+        } catch (const std::exception&) {
+            return false;
+        }
+        connection.waiting = true;
+        return true;
+    }
+
+    void finish_deferred() {
+        std::uint64_t value = 0;
+        [[maybe_unused]] const auto ignored = ::read(completions_->fd, &value, sizeof(value));
+        std::vector<Completion> done;
+        {
+            std::lock_guard lock{completions_->mutex};
+            done.swap(completions_->done);
+        }
+        for (auto& completion : done) {
+            const auto it = connections_.find(completion.fd);
+            if (it == connections_.end() || it->second.id != completion.id) {
+                continue;
+            }
+            it->second.out += completion.reply;
+            it->second.waiting = false;
+            read_client(it->second);
+            settle(it->second);
+        }
+    }
+
+    // Drops a connection that is closing and has nothing left to send, or
+    // adjusts what epoll reports for it.
+    void settle(Connection& connection) {
+        if (connection.closing && connection.out.size() == connection.sent) {
+            drop(connection.fd);
+        } else {
+            update_interest(connection);
+        }
+    }
+
+    void write_client(Connection& connection) {
+        while (connection.sent < connection.out.size()) {
+            const auto count = ::send(connection.fd, connection.out.data() + connection.sent,
+                                      connection.out.size() - connection.sent, MSG_NOSIGNAL);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    connection.closing = true;
+                    connection.out.clear();
+                    connection.sent = 0;
+                }
+                return;
+            }
+            connection.sent += static_cast<std::size_t>(count);
+        }
+        connection.out.clear();
+        connection.sent = 0;
+    }
+
+    void update_interest(Connection& connection) {
+        const auto pending = connection.out.size() - connection.sent;
+        std::uint32_t interest = 0;
+        if (!connection.closing && !connection.waiting && pending < options_.max_pending_output) {
+            interest |= EPOLLIN;
+        }
+        if (pending > 0) {
+            interest |= EPOLLOUT;
+        }
+        if (interest != connection.interest) {
+            epoll_event event{};
+            event.events = interest;
+            event.data.fd = connection.fd;
+            ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.interest = interest;
+        }
+    }
+
+    void drop(int fd) {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections_.erase(fd);
+    }
+
+    void close_all() noexcept {
+        for (const auto& [fd, connection] : connections_) {
+            ::close(fd);
+        }
+        connections_.clear();
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+            if (unix_socket_) {
+                ::unlink(endpoint_.c_str());
+            }
+            listen_fd_ = -1;
+        }
+        for (int* fd : {&stop_fd_, &epoll_fd_}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+};
+
+}  // namespace lab04
@@ -0,0 +1,718 @@
+#pragma once
+
+#include <fcntl.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "journal.hpp"
+
+namespace lab04 {
+
+// How a named store gets its segment: Create fails if the name exists,
+// Open fails if it does not, OpenOrCreate attaches when it can.
+enum class SharedStoreMode { Create, Open, OpenOrCreate };
+
+struct SharedStoreOptions {
+    std::size_t shard_count{4};
+    std::size_t records_per_shard{65536};
+    std::size_t vertices_per_shard{262144};
+    // POSIX shared memory object name ("/lab04-store"); an empty name maps
+    // anonymous memory that is only shared with forked workers.
+    std::string name{};
+    // Attaching keeps the records already stored and takes the shard layout
+    // from the segment, ignoring the sizes above.
+    SharedStoreMode mode{SharedStoreMode::Create};
+};
+
+struct SharedFigureHandle {
+    std::uint32_t shard{0};
+    std::uint32_t slot{0};
+
+    friend bool operator==(const SharedFigureHandle&, const SharedFigureHandle&) = default;
+};
+
+namespace detail {
+
+inline constexpr char kSharedStoreMagic[8] = {'L', '4', 'S', 'H', 'M', '0', '0', '2'};
+
+enum class ShardOp : std::uint32_t { None = 0, TotalArea = 1, Window = 2, Stop = 3 };
+
+// Everything below lives inside the mapping, so it holds offsets relative
+// to its shard instead of pointers and must stay trivially copyable.
+template <Scalar T>
+struct SharedVertex {
+    T x;
+    T y;
+};
+
+struct SharedRecord {
+    std::uint8_t shape;
+    std::uint8_t live;
+    std::uint32_t vertex_count;
+    std::uint64_t first_vertex;
+    double area;
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+};
+
+struct ShardHeader {
+    sem_t request;
+    sem_t response;
+    std::atomic<std::uint32_t> size;
+    std::uint64_t vertices_used;
+    std::uint64_t records_offset;
+    std::uint64_t vertices_offset;
+    std::uint64_t hits_offset;
+
+    // Mailbox: written by the coordinator before posting `request`, by the
+    // worker before posting `response`.
+    ShardOp op;
+    double window[4];
+    double area_result;
+    std::uint32_t hit_count;
+};
+
+struct StoreHeader {
+    char magic[8];
+    std::uint32_t shard_count;
+    std::uint32_t records_per_shard;
+    std::uint64_t vertices_per_shard;
+    std::uint64_t shard_stride;
+    std::uint32_t vertex_size;
+    // Process id of the coordinator attached to the store, 0 when none is.
+    std::atomic<std::int32_t> coordinator;
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free && std::atomic<std::int32_t>::is_always_lock_free,
+              "shard counters must be usable across processes");
+
+[[nodiscard]] inline bool process_exists(pid_t pid) noexcept {
+    return ::kill(pid, 0) == 0 || errno == EPERM;
+}
+
+// Reads or writes (per `io`) exactly `size` bytes; false on end of file or
+// error. Only uses system calls, so the spawner may call it after fork().
+template <typename Io, typename Buffer>
+[[nodiscard]] bool transfer_all(Io io, int fd, Buffer* buffer, std::size_t size) noexcept {
+    auto* bytes = reinterpret_cast<char*>(buffer);
+    while (size > 0) {
+        const auto count = io(fd, bytes, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        size -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+[[nodiscard]] constexpr std::size_t align_up(std::size_t value, std::size_t alignment) noexcept {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace detail
+
+// Figure store partitioned into shards inside one shared mapping. Records and
+// vertices are flat structs addressed by offsets, so the same bytes are
+// valid in every process. Each shard is served by a forked worker that
+// answers aggregate queries over its records; the object itself is the
+// coordinator: it appends and erases records, fans queries out to all
+// workers and merges the replies. The data belongs to the mapping, not to
+// the workers, so a worker that dies is simply restarted and asked again.
+// Only the coordinator mutates records, and never while a query is in
+// flight. Not thread-safe.
+//
+// Workers are not forked by the coordinator but by a single-threaded
+// spawner process the constructor forks, restarts included. Construct the
+// store before the program starts any threads; after that it may run
+// thread pools freely without a worker ever being forked from them.
+//
+// A named segment outlives the object: the destructor stops the workers and
+// unmaps it, and a later store opened with the same name attaches to the
+// records and becomes their coordinator, one at a time. destroy() removes
+// the segment for good.
+template <Scalar T>
+class SharedFigureStore {
+public:
+    using handle_type = SharedFigureHandle;
+
+    explicit SharedFigureStore(SharedStoreOptions options = {}) : options_(std::move(options)) {
+        if (options_.shard_count == 0 || options_.records_per_shard == 0) {
+            throw std::invalid_argument("shared store needs at least one shard and record");
+        }
+        map();
+        workers_.assign(shard_count(), -1);
+        try {
+            start_spawner();
+            for (std::size_t i = 0; i < shard_count(); ++i) {
+                spawn(i);
+            }
+        } catch (...) {
+            shutdown();
+            if (created_) {
+                ::shm_unlink(options_.name.c_str());
+            }
+            throw;
+        }
+    }
+
+    SharedFigureStore(const SharedFigureStore&) = delete;
+    SharedFigureStore& operator=(const SharedFigureStore&) = delete;
+
+    ~SharedFigureStore() { shutdown(); }
+
+    // Stops the workers and removes the named segment, records included;
+    // the store cannot be used afterwards.
+    void destroy() {
+        shutdown();
+        if (!options_.name.empty() && ::shm_unlink(options_.name.c_str()) != 0 && errno != ENOENT) {
+            detail::throw_errno("cannot remove shared memory " + options_.name);
+        }
+    }
+
+    [[nodiscard]] std::size_t shard_count() const noexcept { return options_.shard_count; }
+    [[nodiscard]] std::size_t size() const noexcept { return live_; }
+    [[nodiscard]] bool empty() const noexcept { return live_ == 0; }
+    // Whether the segment was made by this object rather than attached to.
+    [[nodiscard]] bool created() const noexcept { return created_; }
+    [[nodiscard]] std::size_t respawns() const noexcept { return respawns_; }
+    [[nodiscard]] pid_t worker_pid(std::size_t shard) const { return workers_.at(shard); }
+
+    // Copies the figure into the shard with the fewest records.
+    handle_type insert(const Figure<T>& figure) {
+        const auto code = detail::shape_code(&figure);
+        const auto count = figure.vertex_count();
+
+        std::size_t best = shard_count();
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            auto& header = shard(i);
+            const auto size = header.size.load(std::memory_order_relaxed);
+            if (size < options_.records_per_shard &&
+                header.vertices_used + count <= options_.vertices_per_shard &&
+                (best == shard_count() || size < shard(best).size.load(std::memory_order_relaxed))) {
+                best = i;
+            }
+        }
+        if (best == shard_count()) {
+            throw std::length_error("shared figure store is full");
+        }
+
+        auto& header = shard(best);
+        const auto slot = header.size.load(std::memory_order_relaxed);
+        auto* vertices = vertex_base(best) + header.vertices_used;
+        auto& record = records(best)[slot];
+        record = detail::SharedRecord{static_cast<std::uint8_t>(code), 1, static_cast<std::uint32_t>(count),
+                                      header.vertices_used, figure.area(), 0.0, 0.0, 0.0, 0.0};
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto point = figure.vertex(i);
+            vertices[i] = detail::SharedVertex<T>{point.x(), point.y()};
+            const auto x = static_cast<double>(point.x());
+            const auto y = static_cast<double>(point.y());
+            record.min_x = i == 0 ? x : std::min(record.min_x, x);
+            record.min_y = i == 0 ? y : std::min(record.min_y, y);
+            record.max_x = i == 0 ? x : std::max(record.max_x, x);
+            record.max_y = i == 0 ? y : std::max(record.max_y, y);
+        }
+        header.vertices_used += count;
+        header.size.store(slot + 1, std::memory_order_release);
+        ++live_;
+        return handle_type{static_cast<std::uint32_t>(best), slot};
+    }
+
+    // Tombstones the record; its slot and vertices are not reused.
+    void erase(handle_type handle) {
+        auto& record = checked_record(handle);
+        if (record.live) {
+            record.live = 0;
+            --live_;
+        }
+    }
+
+    [[nodiscard]] bool contains(handle_type handle) const {
+        return handle.shard < shard_count() && handle.slot < shard(handle.shard).size.load() &&
+               records(handle.shard)[handle.slot].live != 0;
+    }
+
+    [[nodiscard]] std::shared_ptr<Figure<T>> load(handle_type handle) const {
+        const auto& record = checked_record(handle);
+        if (!record.live) {
+            throw std::out_of_range("shared figure was erased");
+        }
+        std::vector<Point<T>> points;
+        points.reserve(record.vertex_count);
+        const auto* vertices = vertex_base(handle.shard) + record.first_vertex;
+        for (std::uint32_t i = 0; i < record.vertex_count; ++i) {
+            points.emplace_back(vertices[i].x, vertices[i].y);
+        }
+        std::shared_ptr<Figure<T>> figure;
+        if (!detail::make_figure(static_cast<detail::ShapeCode>(record.shape), std::move(points), figure)) {
+            throw std::runtime_error("corrupted shared figure record");
+        }
+        return figure;
+    }
+
+    [[nodiscard]] double total_area() {
+        dispatch(detail::ShardOp::TotalArea, {});
+        double total = 0.0;
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            total += shard(i).area_result;
+        }
+        return total;
+    }
+
+    // Handles of live figures whose bounding box intersects the window.
+    [[nodiscard]] std::vector<handle_type> query_window(const Point<T>& min, const Point<T>& max) {
+        dispatch(detail::ShardOp::Window, {static_cast<double>(min.x()), static_cast<double>(min.y()),
+                                           static_cast<double>(max.x()), static_cast<double>(max.y())});
+        std::vector<handle_type> result;
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            const auto* hits = hit_base(i);
+            for (std::uint32_t k = 0; k < shard(i).hit_count; ++k) {
+                result.push_back(handle_type{static_cast<std::uint32_t>(i), hits[k]});
+            }
+        }
+        return result;
+    }
+
+private:
+    static constexpr long kPollNanoseconds = 20'000'000;
+    // Restarts of one shard within a single query before it is given up.
+    static constexpr int kMaxRestarts = 3;
+
+    SharedStoreOptions options_;
+    bool created_{true};
+    std::size_t shard_stride_{0};
+    std::size_t mapping_size_{0};
+    char* base_{nullptr};
+    std::vector<pid_t> workers_;
+    pid_t spawner_{-1};
+    // Coordinator ends of the pipes to the spawner: shard indices go out,
+    // worker pids (or -errno) come back.
+    int spawn_requests_{-1};
+    int spawn_replies_{-1};
+    std::size_t live_{0};
+    std::size_t respawns_{0};
+
+    [[nodiscard]] detail::ShardHeader& shard(std::size_t index) const noexcept {
+        return *reinterpret_cast<detail::ShardHeader*>(shard_base(index));
+    }
+
+    [[nodiscard]] char* shard_base(std::size_t index) const noexcept {
+        return base_ + detail::align_up(sizeof(detail::StoreHeader), alignof(std::max_align_t)) +
+               index * shard_stride_;
+    }
+
+    [[nodiscard]] detail::SharedRecord* records(std::size_t index) const noexcept {
+        return reinterpret_cast<detail::SharedRecord*>(shard_base(index) + shard(index).records_offset);
+    }
+
+    [[nodiscard]] detail::SharedVertex<T>* vertex_base(std::size_t index) const noexcept {
+        return reinterpret_cast<detail::SharedVertex<T>*>(shard_base(index) + shard(index).vertices_offset);
+    }
+
+    [[nodiscard]] std::uint32_t* hit_base(std::size_t index) const noexcept {
+        return reinterpret_cast<std::uint32_t*>(shard_base(index) + shard(index).hits_offset);
+    }
+
+    detail::SharedRecord& checked_record(handle_type handle) const {
+        if (handle.shard >= shard_count() || handle.slot >= shard(handle.shard).size.load()) {
+            throw std::out_of_range("shared figure handle out of range");
+        }
+        return records(handle.shard)[handle.slot];
+    }
+
+    void layout() {
+        using detail::align_up;
+        constexpr auto align = alignof(std::max_align_t);
+        const auto records_offset = align_up(sizeof(detail::ShardHeader), align);
+        const auto vertices_offset =
+            align_up(records_offset + options_.records_per_shard * sizeof(detail::SharedRecord), align);
+        const auto hits_offset = align_up(
+            vertices_offset + options_.vertices_per_shard * sizeof(detail::SharedVertex<T>), align);
+        shard_stride_ = align_up(hits_offset + options_.records_per_shard * sizeof(std::uint32_t), align);
+        mapping_size_ = align_up(sizeof(detail::StoreHeader), align) + options_.shard_count * shard_stride_;
+    }
+
+    [[nodiscard]] detail::StoreHeader& store_header() const noexcept {
+        return *reinterpret_cast<detail::StoreHeader*>(base_);
+    }
+
+    void map() {
+        if (options_.name.empty()) {
+            layout();
+            map_fresh(-1);
+            return;
+        }
+        if (options_.mode != SharedStoreMode::Open) {
+            const int fd = ::shm_open(options_.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd >= 0) {
+                layout();
+                try {
+                    map_fresh(fd);
+                } catch (...) {
+                    ::close(fd);
+                    ::shm_unlink(options_.name.c_str());
+                    throw;
+                }
+                ::close(fd);
+                return;
+            }
+            if (errno != EEXIST || options_.mode == SharedStoreMode::Create) {
+                detail::throw_errno("cannot create shared memory " + options_.name);
+            }
+        }
+        const int fd = ::shm_open(options_.name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            detail::throw_errno("cannot open shared memory " + options_.name);
+        }
+        try {
+            attach(fd);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    }
+
+    // Maps a new segment of mapping_size_ bytes (anonymous for fd < 0) and
+    // lays out empty shards in it.
+    void map_fresh(int fd) {
+        if (fd >= 0 && ::ftruncate(fd, static_cast<off_t>(mapping_size_)) != 0) {
+            detail::throw_errno("cannot size shared memory " + options_.name);
+        }
+        const int flags = fd < 0 ? MAP_SHARED | MAP_ANONYMOUS : MAP_SHARED;
+        void* address = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, flags, fd, 0);
+        if (address == MAP_FAILED) {
+            detail::throw_errno("cannot map shared figure store");
+        }
+        base_ = static_cast<char*>(address);
+
+        auto* header = new (base_) detail::StoreHeader{};
+        std::copy(std::begin(detail::kSharedStoreMagic), std::end(detail::kSharedStoreMagic), header->magic);
+        header->shard_count = static_cast<std::uint32_t>(options_.shard_count);
+        header->records_per_shard = static_cast<std::uint32_t>(options_.records_per_shard);
+        header->vertices_per_shard = options_.vertices_per_shard;
+        header->shard_stride = shard_stride_;
+        header->vertex_size = sizeof(detail::SharedVertex<T>);
+        header->coordinator.store(::getpid());
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            init_shard(i);
+        }
+    }
+
+    void attach(int fd) {
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            detail::throw_errno("cannot inspect shared memory " + options_.name);
+        }
+        const auto size = static_cast<std::size_t>(info.st_size);
+        if (size < sizeof(detail::StoreHeader)) {
+            throw std::runtime_error(options_.name + " is not a shared figure store");
+        }
+        void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            detail::throw_errno("cannot map shared figure store");
+        }
+        base_ = static_cast<char*>(address);
+        mapping_size_ = size;
+        try {
+            adopt();
+        } catch (...) {
+            ::munmap(base_, mapping_size_);
+            base_ = nullptr;
+            throw;
+        }
+        created_ = false;
+    }
+
+    // Checks the header of an existing segment, claims it for this process
+    // and prepares fresh mailboxes for the workers about to be started.
+    void adopt() {
+        auto& header = store_header();
+        if (!std::equal(std::begin(detail::kSharedStoreMagic), std::end(detail::kSharedStoreMagic), header.magic) ||
+            header.vertex_size != sizeof(detail::SharedVertex<T>) || header.shard_count == 0 ||
+            header.records_per_shard == 0) {
+            throw std::runtime_error(options_.name + " is not a shared figure store of this type");
+        }
+        options_.shard_count = header.shard_count;
+        options_.records_per_shard = header.records_per_shard;
+        options_.vertices_per_shard = static_cast<std::size_t>(header.vertices_per_shard);
+        const auto mapped = mapping_size_;
+        layout();
+        if (mapping_size_ != mapped || shard_stride_ != header.shard_stride) {
+            throw std::runtime_error(options_.name + " has an unexpected layout");
+        }
+
+        auto owner = header.coordinator.load();
+        if ((owner != 0 && detail::process_exists(owner)) ||
+            !header.coordinator.compare_exchange_strong(owner, ::getpid())) {
+            throw std::runtime_error(options_.name + " is in use by process " + std::to_string(owner));
+        }
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            ::sem_destroy(&shard(i).request);
+            ::sem_destroy(&shard(i).response);
+            reset_mailbox(i);
+            const auto size = shard(i).size.load();
+            const auto* rows = records(i);
+            for (std::uint32_t k = 0; k < size; ++k) {
+                live_ += rows[k].live != 0;
+            }
+        }
+    }
+
+    void init_shard(std::size_t index) {
+        using detail::align_up;
+        constexpr auto align = alignof(std::max_align_t);
+        auto* header = new (shard_base(index)) detail::ShardHeader{};
+        header->size.store(0);
+        header->records_offset = align_up(sizeof(detail::ShardHeader), align);
+        header->vertices_offset =
+            align_up(header->records_offset + options_.records_per_shard * sizeof(detail::SharedRecord), align);
+        header->hits_offset = align_up(
+            header->vertices_offset + options_.vertices_per_shard * sizeof(detail::SharedVertex<T>), align);
+        reset_mailbox(index);
+    }
+
+    void reset_mailbox(std::size_t index) {
+        auto& header = shard(index);
+        if (::sem_init(&header.request, 1, 0) != 0 || ::sem_init(&header.response, 1, 0) != 0) {
+            detail::throw_errno("cannot initialize shard semaphores");
+        }
+        header.op = detail::ShardOp::None;
+    }
+
+    void start_spawner() {
+        int requests[2];
+        int replies[2];
+        if (::pipe2(requests, O_CLOEXEC) != 0) {
+            detail::throw_errno("cannot start shard spawner");
+        }
+        if (::pipe2(replies, O_CLOEXEC) != 0) {
+            const int saved = errno;
+            ::close(requests[0]);
+            ::close(requests[1]);
+            errno = saved;
+            detail::throw_errno("cannot start shard spawner");
+        }
+        const auto pid = ::fork();
+        if (pid == 0) {
+            ::close(requests[1]);
+            ::close(replies[0]);
+            run_spawner(requests[0], replies[1]);
+            ::_exit(0);
+        }
+        const int saved = errno;
+        ::close(requests[0]);
+        ::close(replies[1]);
+        if (pid < 0) {
+            ::close(requests[1]);
+            ::close(replies[0]);
+            errno = saved;
+            detail::throw_errno("cannot start shard spawner");
+        }
+        spawner_ = pid;
+        spawn_requests_ = requests[1];
+        spawn_replies_ = replies[0];
+    }
+
+    // Spawner main loop: forks a worker for each shard index read from
+    // `requests` and answers with its pid. SIGCHLD is ignored so the kernel
+    // reaps dead workers and the coordinator sees them vanish; once the
+    // coordinator hangs up, waits for the workers still running.
+    void run_spawner(int requests, int replies) noexcept {
+        ::signal(SIGCHLD, SIG_IGN);
+        std::uint32_t index = 0;
+        while (detail::transfer_all(::read, requests, &index, sizeof(index))) {
+            auto pid = ::fork();
+            if (pid == 0) {
+                ::close(requests);
+                ::close(replies);
+                serve(index);
+                ::_exit(0);
+            }
+            if (pid < 0) {
+                pid = -errno;
+            }
+            if (!detail::transfer_all(::write, replies, &pid, sizeof(pid))) {
+                break;
+            }
+        }
+        while (::wait(nullptr) > 0 || errno == EINTR) {
+        }
+    }
+
+    void spawn(std::size_t index) {
+        auto request = static_cast<std::uint32_t>(index);
+        pid_t pid = 0;
+        if (!detail::transfer_all(::write, spawn_requests_, &request, sizeof(request)) ||
+            !detail::transfer_all(::read, spawn_replies_, &pid, sizeof(pid))) {
+            throw std::runtime_error("shard spawner is gone");
+        }
+        if (pid < 0) {
+            errno = -pid;
+            detail::throw_errno("cannot start shard worker");
+        }
+        workers_[index] = pid;
+    }
+
+    // Worker main loop. Runs in the child right after fork(), so it only
+    // reads the mapping and never allocates.
+    void serve(std::size_t index) noexcept {
+        auto& header = shard(index);
+        while (true) {
+            while (::sem_wait(&header.request) != 0) {
+            }
+            const auto op = header.op;
+            if (op == detail::ShardOp::Stop) {
+                return;
+            }
+            const auto size = header.size.load(std::memory_order_acquire);
+            const auto* rows = records(index);
+            if (op == detail::ShardOp::TotalArea) {
+                double sum = 0.0;
+                for (std::uint32_t i = 0; i < size; ++i) {
+                    sum += rows[i].live ? rows[i].area : 0.0;
+                }
+                header.area_result = sum;
+            } else if (op == detail::ShardOp::Window) {
+                auto* hits = hit_base(index);
+                std::uint32_t count = 0;
+                for (std::uint32_t i = 0; i < size; ++i) {
+                    const auto& row = rows[i];
+                    if (row.live && row.max_x >= header.window[0] && row.min_x <= header.window[2] &&
+                        row.max_y >= header.window[1] && row.min_y <= header.window[3]) {
+                        hits[count++] = i;
+                    }
+                }
+                header.hit_count = count;
+            }
+            ::sem_post(&header.response);
+        }
+    }
+
+    // Workers are the spawner's children and the kernel reaps them, so only
+    // the process table can tell whether one still runs.
+    [[nodiscard]] bool worker_alive(std::size_t index) const noexcept {
+        return detail::process_exists(workers_[index]);
+    }
+
+    void restart(std::size_t index) {
+        auto& header = shard(index);
+        ::sem_destroy(&header.request);
+        ::sem_destroy(&header.response);
+        reset_mailbox(index);
+        spawn(index);
+        ++respawns_;
+    }
+
+    void post(std::size_t index, detail::ShardOp op, const std::array<double, 4>& window) {
+        auto& header = shard(index);
+        header.op = op;
+        std::copy(window.begin(), window.end(), header.window);
+        ::sem_post(&header.request);
+    }
+
+    void dispatch(detail::ShardOp op, const std::array<double, 4>& window) {
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            if (!worker_alive(i)) {
+                restart(i);
+            }
+            post(i, op, window);
+        }
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            for (int restarts = 0; !await(i); ++restarts) {
+                if (restarts == kMaxRestarts) {
+                    throw std::runtime_error("shard worker " + std::to_string(i) + " keeps failing");
+                }
+                restart(i);
+                post(i, op, window);
+            }
+        }
+    }
+
+    // Waits for the shard's reply; returns false once its worker has died.
+    [[nodiscard]] bool await(std::size_t index) {
+        auto& header = shard(index);
+        while (true) {
+            timespec deadline{};
+            ::clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += kPollNanoseconds;
+            if (deadline.tv_nsec >= 1'000'000'000) {
+                deadline.tv_nsec -= 1'000'000'000;
+                ++deadline.tv_sec;
+            }
+            if (::sem_timedwait(&header.response, &deadline) == 0) {
+                return true;
+            }
+            if (errno != ETIMEDOUT && errno != EINTR) {
+                detail::throw_errno("cannot wait for shard worker");
+            }
+            if (!worker_alive(index)) {
+                return false;
+            }
+        }
+    }
+
+    // Stops the workers and unmaps the segment; a named one stays behind
+    // for the next coordinator.
+    void shutdown() noexcept {
+        if (base_ == nullptr) {
+            return;
+        }
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+            if (workers_[i] <= 0) {
+                continue;
+            }
+            if (worker_alive(i)) {
+                post(i, detail::ShardOp::Stop, {});
+            }
+            workers_[i] = -1;
+        }
+        // Hanging up lets the spawner wait for the stopped workers and exit.
+        for (int* fd : {&spawn_requests_, &spawn_replies_}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+        if (spawner_ > 0) {
+            int status = 0;
+            while (::waitpid(spawner_, &status, 0) < 0 && errno == EINTR) {
+            }
+            spawner_ = -1;
+        }
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            ::sem_destroy(&shard(i).request);
+            ::sem_destroy(&shard(i).response);
+        }
+        auto owner = static_cast<std::int32_t>(::getpid());
+        store_header().coordinator.compare_exchange_strong(owner, 0);
+        ::munmap(base_, mapping_size_);
+        base_ = nullptr;
+    }
+};
+
+}  // namespace lab04
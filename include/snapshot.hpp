@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include "arena.hpp"
+#include "array.hpp"
+#include "figure.hpp"
+
+namespace lab04 {
+
+namespace detail {
+
+// Owns the arena of one deep snapshot or bulk-built batch and the figures
+// placed in it. The figure table itself also lives in the arena.
+template <Scalar T>
+class SnapshotBlock {
+public:
+    explicit SnapshotBlock(std::size_t bytes) : arena_(bytes) {}
+
+    SnapshotBlock(const SnapshotBlock&) = delete;
+    SnapshotBlock& operator=(const SnapshotBlock&) = delete;
+
+    ~SnapshotBlock() {
+        for (auto* figure : figures_) {
+            if (figure != nullptr) {
+                figure->~Figure<T>();
+            }
+        }
+    }
+
+    [[nodiscard]] Arena& arena() noexcept { return arena_; }
+
+    void reserve_table(std::size_t count) {
+        auto* table = static_cast<Figure<T>**>(arena_.allocate(count * sizeof(Figure<T>*), alignof(Figure<T>*)));
+        for (std::size_t i = 0; i < count; ++i) {
+            table[i] = nullptr;
+        }
+        figures_ = std::span<Figure<T>*>{table, count};
+    }
+
+    Figure<T>* place(std::size_t index, const Figure<T>& figure) {
+        figures_[index] = figure.clone_into(arena_);
+        return figures_[index];
+    }
+
+    // Takes ownership of a figure already constructed in arena().
+    Figure<T>* adopt(std::size_t index, Figure<T>* figure) noexcept {
+        figures_[index] = figure;
+        return figure;
+    }
+
+private:
+    Arena arena_;
+    std::span<Figure<T>*> figures_{};
+};
+
+}  // namespace detail
+
+// Deep copy of `figures` that shares nothing with the source. The footprints
+// are summed first so every figure and vertex is placed in one pre-sized
+// arena block; the returned pointers alias a single owner and the whole
+// block is released when the last of them goes away. Empty slots stay empty.
+template <Scalar T, typename Growth>
+Array<std::shared_ptr<Figure<T>>> deep_snapshot(const Array<std::shared_ptr<Figure<T>>, Growth>& figures) {
+    std::size_t bytes = arena_footprint<Figure<T>*>(figures.size());
+    for (const auto& figure : figures) {
+        if (figure) {
+            bytes += figure->snapshot_footprint();
+        }
+    }
+
+    auto block = std::make_shared<detail::SnapshotBlock<T>>(bytes);
+    block->reserve_table(figures.size());
+
+    Array<std::shared_ptr<Figure<T>>> snapshot(figures.size());
+    for (std::size_t i = 0; i < figures.size(); ++i) {
+        const auto& figure = figures[i];
+        snapshot.push_back(figure ? std::shared_ptr<Figure<T>>(block, block->place(i, *figure)) : nullptr);
+    }
+    return snapshot;
+}
+
+}  // namespace lab04
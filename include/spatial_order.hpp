@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "array.hpp"
+#include "figure.hpp"
+#include "task_executor.hpp"
+
+namespace lab04 {
+
+namespace detail {
+
+// Inserts a zero bit above every bit of `value`: abcd -> 0a0b0c0d.
+[[nodiscard]] constexpr std::uint64_t spread_bits(std::uint32_t value) noexcept {
+    std::uint64_t x = value;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+[[nodiscard]] constexpr std::uint64_t interleave(std::uint32_t x, std::uint32_t y) noexcept {
+    return spread_bits(x) | (spread_bits(y) << 1);
+}
+
+struct KeyedIndex {
+    std::uint64_t key;
+    std::size_t index;
+};
+
+// LSD radix sort by `key`, one byte per pass. Every pass the digits of
+// each slice are counted, the offsets laid out digit-major and slice-minor,
+// and each slice scattered; that keeps the sort stable. Passes in which all
+// keys share a digit are skipped. Slices run as tasks on `pool`, or as a
+// single slice on the calling thread without one.
+inline void radix_sort(std::vector<KeyedIndex>& items, ThreadPool* pool) {
+    constexpr std::size_t kRadix = 256;
+    constexpr std::size_t kPasses = sizeof(std::uint64_t);
+    const auto count = items.size();
+    if (count < 2) {
+        return;
+    }
+    const auto slices = pool == nullptr ? std::size_t{1} : std::min(pool->size(), count / 4096 + 1);
+
+    std::vector<KeyedIndex> buffer(count);
+    auto* source = items.data();
+    auto* target = buffer.data();
+    std::vector<std::array<std::size_t, kRadix>> offsets(slices);
+    const auto each_slice = [&](auto&& fn) {
+        const auto run = [&](std::size_t first, std::size_t last) {
+            for (auto slice = first; slice < last; ++slice) {
+                fn(offsets[slice], count * slice / slices, count * (slice + 1) / slices);
+            }
+        };
+        if (pool == nullptr) {
+            run(0, slices);
+        } else {
+            pool->parallel_for(slices, 1, run);
+        }
+    };
+
+    for (std::size_t pass = 0; pass < kPasses; ++pass) {
+        const auto digit = [shift = 8 * pass](const KeyedIndex& item) { return (item.key >> shift) & (kRadix - 1); };
+        each_slice([&](std::array<std::size_t, kRadix>& histogram, std::size_t first, std::size_t last) {
+            histogram.fill(0);
+            for (auto i = first; i < last; ++i) {
+                ++histogram[digit(source[i])];
+            }
+        });
+        bool skip = false;
+        std::size_t running = 0;
+        for (std::size_t d = 0; d < kRadix; ++d) {
+            std::size_t bucket = 0;
+            for (auto& histogram : offsets) {
+                const auto size = histogram[d];
+                histogram[d] = running;
+                running += size;
+                bucket += size;
+            }
+            skip = skip || bucket == count;
+        }
+        if (skip) {
+            continue;
+        }
+        each_slice([&](std::array<std::size_t, kRadix>& histogram, std::size_t first, std::size_t last) {
+            for (auto i = first; i < last; ++i) {
+                target[histogram[digit(source[i])]++] = source[i];
+            }
+        });
+        std::swap(source, target);
+    }
+    if (source != items.data()) {
+        items.swap(buffer);
+    }
+}
+
+}  // namespace detail
+
+// Z-order keys of the figure centers, quantized to 32 bits per axis over the
+// bounding box of all centers. Figures use at most 2^32 - 2 cells per axis,
+// so the largest key, given to empty slots, is theirs alone.
+template <Scalar T, typename Growth>
+std::vector<std::uint64_t> morton_keys(const Array<std::shared_ptr<Figure<T>>, Growth>& figures) {
+    double min_x = std::numeric_limits<double>::infinity();
+    double min_y = min_x;
+    double max_x = -min_x;
+    double max_y = -min_x;
+    std::vector<Point<double>> centers(figures.size());
+    for (std::size_t i = 0; i < figures.size(); ++i) {
+        if (const auto& figure = figures[i]) {
+            const auto center = figure->center();
+            centers[i] = Point<double>{static_cast<double>(center.x()), static_cast<double>(center.y())};
+            min_x = std::min(min_x, centers[i].x());
+            min_y = std::min(min_y, centers[i].y());
+            max_x = std::max(max_x, centers[i].x());
+            max_y = std::max(max_y, centers[i].y());
+        }
+    }
+
+    constexpr double kCells = 4294967294.0;
+    const auto quantize = [](double value, double low, double high) {
+        if (!(high > low)) {
+            return std::uint32_t{0};
+        }
+        const auto scaled = std::clamp((value - low) / (high - low), 0.0, 1.0) * kCells;
+        return static_cast<std::uint32_t>(std::llround(scaled));
+    };
+
+    std::vector<std::uint64_t> keys(figures.size(), std::numeric_limits<std::uint64_t>::max());
+    for (std::size_t i = 0; i < figures.size(); ++i) {
+        if (figures[i]) {
+            keys[i] = detail::interleave(quantize(centers[i].x(), min_x, max_x),
+                                         quantize(centers[i].y(), min_y, max_y));
+        }
+    }
+    return keys;
+}
+
+namespace detail {
+
+template <Scalar T, typename Growth>
+std::vector<std::size_t> reorder_spatially_on(Array<std::shared_ptr<Figure<T>>, Growth>& figures,
+                                              ThreadPool* pool) {
+    const auto keys = morton_keys(figures);
+    std::vector<KeyedIndex> order(figures.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = KeyedIndex{keys[i], i};
+    }
+    radix_sort(order, pool);
+
+    std::vector<std::size_t> new_index(figures.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        new_index[order[i].index] = i;
+    }
+
+    // Cycle-following: each figure is moved once, without a second array.
+    std::vector<bool> placed(figures.size(), false);
+    for (std::size_t start = 0; start < figures.size(); ++start) {
+        if (placed[start]) {
+            continue;
+        }
+        auto carried = std::move(figures[start]);
+        auto slot = start;
+        while (!placed[new_index[slot]]) {
+            const auto next = new_index[slot];
+            std::swap(carried, figures[next]);
+            placed[next] = true;
+            slot = next;
+        }
+    }
+    return new_index;
+}
+
+}  // namespace detail
+
+// Permutes `figures` in place into Z-order of their centers so that figures
+// close in the plane end up close in memory. Equal keys keep their relative
+// order and empty slots move to the end. Returns the new position of every
+// old index; indices held elsewhere (a journal, hit-test index or handles)
+// must be rewritten or rebuilt through it.
+//
+// This overload runs the radix sort of the keys as tasks on `pool`.
+template <Scalar T, typename Growth>
+std::vector<std::size_t> reorder_spatially(Array<std::shared_ptr<Figure<T>>, Growth>& figures, ThreadPool& pool) {
+    return detail::reorder_spatially_on(figures, &pool);
+}
+
+// Sorts on the calling thread, or with thread_count > 1 (0 means hardware
+// concurrency) on a pool of that many threads made for the call.
+template <Scalar T, typename Growth>
+std::vector<std::size_t> reorder_spatially(Array<std::shared_ptr<Figure<T>>, Growth>& figures,
+                                           std::size_t thread_count = 1) {
+    if (thread_count == 1) {
+        return detail::reorder_spatially_on(figures, nullptr);
+    }
+    ThreadPool pool{thread_count};
+    return detail::reorder_spatially_on(figures, &pool);
+}
+
+}  // namespace lab04
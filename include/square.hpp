@@ -5,13 +5,13 @@
 #include <stdexcept>
 #include <type_traits>
 
-#include "polygon.hpp"
+#include "axis_aligned.hpp"
 
 namespace lab04 {
 
 template <Scalar T>
-class Square : public PolygonFigure<Square<T>, T, 4> {
-    using base_type = PolygonFigure<Square<T>, T, 4>;
+class Square : public AxisAlignedFigure<Square<T>, T> {
+    using base_type = AxisAlignedFigure<Square<T>, T>;
     using point_type = typename base_type::point_type;
 
 public:
@@ -21,16 +21,19 @@ public:
         if (side <= static_cast<T>(0)) {
             throw std::invalid_argument("square side must be positive");
         }
-        using real = std::common_type_t<T, double>;
-        const auto half_side = static_cast<real>(side) / static_cast<real>(2);
-        const auto cx = static_cast<real>(center.x());
-        const auto cy = static_cast<real>(center.y());
-        std::array<point_type, 4> points{
-            point_type{static_cast<T>(cx - half_side), static_cast<T>(cy - half_side)},
-            point_type{static_cast<T>(cx + half_side), static_cast<T>(cy - half_side)},
-            point_type{static_cast<T>(cx + half_side), static_cast<T>(cy + half_side)},
-            point_type{static_cast<T>(cx - half_side), static_cast<T>(cy + half_side)}};
-        this->assign(points);
+        this->assign_centered(center, side, side);
+    }
+
+    // Rebuilds a square from vertices in the order produced by the center
+    // constructor; used when restoring persisted figures bit-for-bit.
+    [[nodiscard]] static Square from_vertices(const std::array<point_type, 4>& points) {
+        if (!base_type::is_axis_aligned(points) ||
+            !almost_equal(points[1].x() - points[0].x(), points[2].y() - points[1].y())) {
+            throw std::invalid_argument("vertices do not form an axis-aligned square");
+        }
+        Square square;
+        square.assign_bounds(points[0].x(), points[0].y(), points[2].x(), points[2].y());
+        return square;
     }
 
     Square(const Square&) = default;
@@ -39,28 +42,13 @@ public:
     Square& operator=(Square&&) noexcept = default;
     ~Square() override = default;
 
-    [[nodiscard]] std::unique_ptr<Figure<T>> clone() const override {
-        return std::make_unique<Square>(*this);
-    }
-
     [[nodiscard]] const char* shape_name() const { return "Square"; }
 
     [[nodiscard]] double inscribed_circle_radius() const {
         return side() / std::sqrt(2.0);
     }
 
-    [[nodiscard]] double side() const {
-        const auto vertices = this->vertices();
-        using real = std::common_type_t<T, double>;
-        const auto dx = static_cast<real>(vertices[1].x()) - static_cast<real>(vertices[0].x());
-        const auto dy = static_cast<real>(vertices[1].y()) - static_cast<real>(vertices[0].y());
-        return std::sqrt(dx * dx + dy * dy);
-    }
-
-private:
-    [[nodiscard]] bool is_equal(const Figure<T>& other) const override {
-        return base_type::is_equal(other);
-    }
+    [[nodiscard]] double side() const { return this->width(); }
 };
 
 }  // namespace lab04
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lab04 {
+
+// Fixed-size pool where every worker owns a deque: it takes its own newest
+// job first and steals the oldest job of another worker when it runs dry.
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t thread_count = 0) {
+        if (thread_count == 0) {
+            thread_count = std::max(1U, std::thread::hardware_concurrency());
+        }
+        queues_.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            queues_.push_back(std::make_unique<WorkQueue>());
+        }
+        threads_.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            threads_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock{wake_mutex_};
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return threads_.size(); }
+
+    void submit(std::function<void()> job) {
+        const auto home = current_pool_ == this ? current_index_
+                                                : next_queue_.fetch_add(1) % queues_.size();
+        {
+            std::lock_guard lock{queues_[home]->mutex};
+            queues_[home]->jobs.push_back(std::move(job));
+            // Counted before the lock is released: nobody can take the job,
+            // and decrement the counter, until then.
+            pending_.fetch_add(1);
+        }
+        {
+            std::lock_guard lock{wake_mutex_};
+        }
+        wake_.notify_one();
+    }
+
+    // Runs one queued job on the calling thread, if any; used by waiters so
+    // that a blocked caller helps instead of idling.
+    bool run_pending_task() {
+        const auto home = current_pool_ == this ? current_index_
+                                                : next_queue_.load() % queues_.size();
+        std::function<void()> job;
+        if (!try_take(home, job)) {
+            return false;
+        }
+        pending_.fetch_sub(1);
+        job();
+        return true;
+    }
+
+    // Calls fn(first, last) for consecutive chunks of [0, count) on the pool
+    // and returns once all chunks are done; the first exception is rethrown.
+    template <typename Fn>
+    void parallel_for(std::size_t count, std::size_t grain, Fn&& fn) {
+        grain = std::max<std::size_t>(1, grain);
+        const auto chunks = (count + grain - 1) / grain;
+        std::atomic<std::size_t> remaining{chunks};
+        std::exception_ptr failure;
+        std::mutex failure_mutex;
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            submit([&, chunk] {
+                try {
+                    fn(chunk * grain, std::min(count, (chunk + 1) * grain));
+                } catch (...) {
+                    std::lock_guard lock{failure_mutex};
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                }
+                remaining.fetch_sub(1);
+            });
+        }
+        while (remaining.load() != 0) {
+            if (!run_pending_task()) {
+                std::this_thread::yield();
+            }
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> next_queue_{0};
+    bool stopping_{false};
+
+    static inline thread_local const ThreadPool* current_pool_ = nullptr;
+    static inline thread_local std::size_t current_index_ = 0;
+
+    bool try_take(std::size_t home, std::function<void()>& job) {
+        {
+            auto& own = *queues_[home];
+            std::lock_guard lock{own.mutex};
+            if (!own.jobs.empty()) {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+        for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+            auto& victim = *queues_[(home + offset) % queues_.size()];
+            std::lock_guard lock{victim.mutex};
+            if (!victim.jobs.empty()) {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(std::size_t index) {
+        current_pool_ = this;
+        current_index_ = index;
+        std::function<void()> job;
+        while (true) {
+            if (try_take(index, job)) {
+                pending_.fetch_sub(1);
+                job();
+                job = nullptr;
+                continue;
+            }
+            std::unique_lock lock{wake_mutex_};
+            wake_.wait(lock, [this] { return stopping_ || pending_.load() > 0; });
+            if (stopping_ && pending_.load() == 0) {
+                return;
+            }
+        }
+    }
+};
+
+enum class TaskStatus { Running, Completed, Cancelled, Failed };
+
+// A command running on the executor. The body reports progress and partial
+// output through this object and polls stop_requested() to honour cancel().
+class BackgroundTask {
+public:
+    BackgroundTask(std::size_t id, std::string name) : id_(id), name_(std::move(name)) {}
+
+    [[nodiscard]] std::size_t id() const noexcept { return id_; }
+    [[nodiscard]] const std::string& name() const noexcept { return name_; }
+
+    [[nodiscard]] TaskStatus status() const {
+        std::lock_guard lock{mutex_};
+        return status_;
+    }
+
+    [[nodiscard]] bool finished() const { return status() != TaskStatus::Running; }
+
+    [[nodiscard]] double progress() const {
+        const auto total = total_.load();
+        if (total == 0) {
+            return finished() ? 1.0 : 0.0;
+        }
+        return static_cast<double>(std::min(done_.load(), total)) / static_cast<double>(total);
+    }
+
+    [[nodiscard]] std::string error() const {
+        std::lock_guard lock{mutex_};
+        return error_;
+    }
+
+    void cancel() noexcept { stop_.request_stop(); }
+
+    [[nodiscard]] bool stop_requested() const noexcept { return stop_.stop_requested(); }
+
+    // For algorithms that poll a token themselves.
+    [[nodiscard]] std::stop_token get_stop_token() const noexcept { return stop_.get_token(); }
+
+    template <typename Rep, typename Period>
+    bool wait_for(std::chrono::duration<Rep, Period> timeout) const {
+        std::unique_lock lock{mutex_};
+        return finished_.wait_for(lock, timeout, [this] { return status_ != TaskStatus::Running; });
+    }
+
+    void wait() const {
+        std::unique_lock lock{mutex_};
+        finished_.wait(lock, [this] { return status_ != TaskStatus::Running; });
+    }
+
+    // Returns the output produced since the previous call.
+    [[nodiscard]] std::string take_output() {
+        std::lock_guard lock{mutex_};
+        return std::exchange(output_, std::string{});
+    }
+
+    void set_total(std::size_t total) noexcept { total_.store(total); }
+    void advance(std::size_t amount = 1) noexcept { done_.fetch_add(amount); }
+
+    void append_output(std::string_view text) {
+        std::lock_guard lock{mutex_};
+        output_.append(text);
+    }
+
+    void finish(TaskStatus status, std::string error = {}) {
+        {
+            std::lock_guard lock{mutex_};
+            status_ = status;
+            error_ = std::move(error);
+        }
+        finished_.notify_all();
+    }
+
+private:
+    std::size_t id_;
+    std::string name_;
+    std::stop_source stop_;
+    std::atomic<std::size_t> total_{0};
+    std::atomic<std::size_t> done_{0};
+    mutable std::mutex mutex_;
+    mutable std::condition_variable finished_;
+    TaskStatus status_{TaskStatus::Running};
+    std::string output_;
+    std::string error_;
+};
+
+// Runs long commands in the background on a work-stealing pool and keeps
+// track of them until the caller forgets them.
+class TaskExecutor {
+public:
+    using body_type = std::function<void(BackgroundTask&)>;
+
+    explicit TaskExecutor(std::size_t thread_count = 0) : pool_(thread_count) {}
+
+    TaskExecutor(const TaskExecutor&) = delete;
+    TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+    ~TaskExecutor() {
+        for (const auto& task : tasks()) {
+            task->cancel();
+        }
+    }
+
+    [[nodiscard]] ThreadPool& pool() noexcept { return pool_; }
+
+    std::shared_ptr<BackgroundTask> launch(std::string name, body_type body) {
+        std::shared_ptr<BackgroundTask> task;
+        {
+            std::lock_guard lock{mutex_};
+            task = std::make_shared<BackgroundTask>(++last_id_, std::move(name));
+            tasks_.push_back(task);
+        }
+        pool_.submit([task, body = std::move(body)] {
+            try {
+                body(*task);
+                task->finish(task->stop_requested() ? TaskStatus::Cancelled : TaskStatus::Completed);
+            } catch (const std::exception& ex) {
+                task->finish(TaskStatus::Failed, ex.what());
+            } catch (...) {
+                task->finish(TaskStatus::Failed, "unknown error");
+            }
+        });
+        return task;
+    }
+
+    [[nodiscard]] std::vector<std::shared_ptr<BackgroundTask>> tasks() const {
+        std::lock_guard lock{mutex_};
+        return tasks_;
+    }
+
+    [[nodiscard]] std::shared_ptr<BackgroundTask> find(std::size_t id) const {
+        std::lock_guard lock{mutex_};
+        for (const auto& task : tasks_) {
+            if (task->id() == id) {
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    void forget(std::size_t id) {
+        std::lock_guard lock{mutex_};
+        std::erase_if(tasks_, [id](const std::shared_ptr<BackgroundTask>& task) { return task->id() == id; });
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<BackgroundTask>> tasks_;
+    std::size_t last_id_{0};
+    ThreadPool pool_;
+};
+
+}  // namespace lab04
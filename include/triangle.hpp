@@ -28,6 +28,13 @@ public:
         if (base_width <= static_cast<T>(0) || height <= static_cast<T>(0)) {
             throw std::invalid_argument("triangle dimensions must be positive");
         }
+        this->assign(centered_vertices(center, base_width, height));
+    }
+
+    // Vertices of the isosceles triangle with the given base and height whose
+    // centroid is `center`: apex first, then the left and right base corners.
+    [[nodiscard]] static std::array<point_type, 3> centered_vertices(const point_type& center, T base_width,
+                                                                     T height) {
         using real = std::common_type_t<T, double>;
         const auto half_base = static_cast<real>(base_width) / static_cast<real>(2);
         const auto h = static_cast<real>(height);
@@ -43,17 +50,17 @@ public:
         const point_type base_right{
             static_cast<T>(cx + half_base),
             static_cast<T>(cy - h / static_cast<real>(3))};
-
-        this->assign({apex, base_left, base_right});
+        return {apex, base_left, base_right};
     }
 
     Triangle(const Triangle&) = default;
     Triangle& operator=(const Triangle&) = default;
-    Triangle(Triangle&&) noexcept = default;
-    Triangle& operator=(Triangle&&) noexcept = default;
+    Triangle(Triangle&&) = default;
+    Triangle& operator=(Triangle&&) = default;
     ~Triangle() override = default;
 
     [[nodiscard]] std::unique_ptr<Figure<T>> clone() const override {
+        LAB04_TRACE_SCOPE("Triangle::clone");
         return std::make_unique<Triangle>(*this);
     }
 
@@ -68,17 +75,7 @@ private:
         const point_type& apex,
         const point_type& base_left,
         const point_type& base_right) {
-        const auto dist_left = squared_distance(apex, base_left);
-        const auto dist_right = squared_distance(apex, base_right);
-        return almost_equal(dist_left, dist_right);
-    }
-
-    template <typename U>
-    [[nodiscard]] static std::common_type_t<U, double> squared_distance(const Point<U>& lhs, const Point<U>& rhs) {
-        using real = std::common_type_t<U, double>;
-        const auto dx = static_cast<real>(lhs.x()) - static_cast<real>(rhs.x());
-        const auto dy = static_cast<real>(lhs.y()) - static_cast<real>(rhs.y());
-        return dx * dx + dy * dy;
+        return equidistant(apex, base_left, base_right);
     }
 };
 
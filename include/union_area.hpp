@@ -0,0 +1,469 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <vector>
+
+#include "array.hpp"
+#include "figure.hpp"
+#include "task_executor.hpp"
+
+namespace lab04 {
+
+namespace detail {
+
+struct AxisBox {
+    double min_x{};
+    double min_y{};
+    double max_x{};
+    double max_y{};
+};
+
+// Edge of a figure outline oriented left to right; crossing it upwards
+// changes the coverage count by `winding`.
+struct SweepEdge {
+    double x0{};
+    double y0{};
+    double x1{};
+    double y1{};
+    int winding{};
+
+    [[nodiscard]] double y_at(double x) const {
+        return y0 + (y1 - y0) * ((x - x0) / (x1 - x0));
+    }
+};
+
+template <Scalar T>
+bool as_axis_box(const Figure<T>& figure, AxisBox& box) {
+    if (figure.vertex_count() != 4) {
+        return false;
+    }
+    for (std::size_t i = 0; i < 4; ++i) {
+        const auto current = figure.vertex(i);
+        const auto next = figure.vertex((i + 1) % 4);
+        const bool horizontal = current.y() == next.y();
+        const bool vertical = current.x() == next.x();
+        if (horizontal == vertical) {
+            return false;
+        }
+    }
+    const auto first = figure.vertex(0);
+    const auto opposite = figure.vertex(2);
+    box.min_x = static_cast<double>(std::min(first.x(), opposite.x()));
+    box.max_x = static_cast<double>(std::max(first.x(), opposite.x()));
+    box.min_y = static_cast<double>(std::min(first.y(), opposite.y()));
+    box.max_y = static_cast<double>(std::max(first.y(), opposite.y()));
+    return box.min_x < box.max_x && box.min_y < box.max_y;
+}
+
+template <Scalar T>
+void append_edges(const Figure<T>& figure, std::vector<SweepEdge>& edges) {
+    const auto count = figure.vertex_count();
+    if (count < 3) {
+        return;
+    }
+    long double doubled_area = 0.0L;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto current = figure.vertex(i);
+        const auto next = figure.vertex((i + 1) % count);
+        doubled_area += static_cast<long double>(current.x()) * static_cast<long double>(next.y());
+        doubled_area -= static_cast<long double>(current.y()) * static_cast<long double>(next.x());
+    }
+    if (doubled_area == 0.0L) {
+        return;
+    }
+    const int orientation = doubled_area > 0.0L ? 1 : -1;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto current = figure.vertex(i);
+        const auto next = figure.vertex((i + 1) % count);
+        const auto ax = static_cast<double>(current.x());
+        const auto ay = static_cast<double>(current.y());
+        const auto bx = static_cast<double>(next.x());
+        const auto by = static_cast<double>(next.y());
+        if (ax == bx) {
+            continue;
+        }
+        if (ax < bx) {
+            edges.push_back(SweepEdge{ax, ay, bx, by, orientation});
+        } else {
+            edges.push_back(SweepEdge{bx, by, ax, ay, -orientation});
+        }
+    }
+}
+
+// Segment tree over compressed y coordinates that keeps the covered length
+// of all intervals with a positive count, and for the mixed sweep the first
+// moment of the covered set about each node's lower bound.
+class CoverageTree {
+public:
+    struct Extent {
+        double length{0.0};
+        // Integral of (top - y) over the covered part of [bottom, top].
+        double weight{0.0};
+    };
+
+    explicit CoverageTree(std::vector<double> ys)
+        : ys_(std::move(ys)),
+          count_(ys_.size() > 1 ? 4 * (ys_.size() - 1) : 0, 0),
+          covered_(count_.size(), 0.0),
+          moment_(count_.size(), 0.0) {}
+
+    void update(std::size_t lo, std::size_t hi, int delta) {
+        if (lo < hi) {
+            update(1, 0, ys_.size() - 1, lo, hi, delta);
+        }
+    }
+
+    [[nodiscard]] double covered() const { return covered_.empty() ? 0.0 : covered_[1]; }
+
+    [[nodiscard]] std::size_t index_of(double y) const {
+        return static_cast<std::size_t>(std::lower_bound(ys_.begin(), ys_.end(), y) - ys_.begin());
+    }
+
+    // Covered part of [bottom, top], bottom <= top, in O(log n).
+    [[nodiscard]] Extent covered_within(double bottom, double top) const {
+        Extent extent;
+        if (!covered_.empty() && bottom < top) {
+            query(1, 0, ys_.size() - 1, bottom, top, extent);
+        }
+        return extent;
+    }
+
+    // Mean of the covered length below y while y runs linearly from `from`
+    // to `to`.
+    [[nodiscard]] double mean_covered_below(double from, double to) const {
+        const auto bottom = std::min(from, to);
+        const auto top = std::max(from, to);
+        const auto below = covered_within(ys_.empty() ? bottom : std::min(ys_.front(), bottom), bottom).length;
+        if (bottom == top) {
+            return below;
+        }
+        return below + covered_within(bottom, top).weight / (top - bottom);
+    }
+
+private:
+    std::vector<double> ys_;
+    std::vector<int> count_;
+    std::vector<double> covered_;
+    std::vector<double> moment_;
+
+    void update(std::size_t node, std::size_t begin, std::size_t end, std::size_t lo, std::size_t hi,
+                int delta) {
+        if (hi <= begin || end <= lo) {
+            return;
+        }
+        if (lo <= begin && end <= hi) {
+            count_[node] += delta;
+        } else {
+            const auto middle = begin + (end - begin) / 2;
+            update(2 * node, begin, middle, lo, hi, delta);
+            update(2 * node + 1, middle, end, lo, hi, delta);
+        }
+        if (count_[node] > 0) {
+            const auto height = ys_[end] - ys_[begin];
+            covered_[node] = height;
+            moment_[node] = height * height / 2.0;
+        } else if (end - begin == 1) {
+            covered_[node] = 0.0;
+            moment_[node] = 0.0;
+        } else {
+            const auto middle = begin + (end - begin) / 2;
+            covered_[node] = covered_[2 * node] + covered_[2 * node + 1];
+            moment_[node] = moment_[2 * node] + moment_[2 * node + 1] +
+                            covered_[2 * node + 1] * (ys_[middle] - ys_[begin]);
+        }
+    }
+
+    void query(std::size_t node, std::size_t begin, std::size_t end, double bottom, double top,
+               Extent& extent) const {
+        const auto lo = std::max(ys_[begin], bottom);
+        const auto hi = std::min(ys_[end], top);
+        if (lo >= hi) {
+            return;
+        }
+        if (count_[node] > 0) {
+            extent.length += hi - lo;
+            extent.weight += (hi - lo) * (top - lo - (hi - lo) / 2.0);
+            return;
+        }
+        if (covered_[node] == 0.0) {
+            return;
+        }
+        if (bottom <= ys_[begin] && ys_[end] <= top) {
+            extent.length += covered_[node];
+            extent.weight += covered_[node] * (top - ys_[begin]) - moment_[node];
+            return;
+        }
+        const auto middle = begin + (end - begin) / 2;
+        query(2 * node, begin, middle, bottom, top, extent);
+        query(2 * node + 1, middle, end, bottom, top, extent);
+    }
+};
+
+// Box edges clipped to [x_lo, x_hi] as sweep events sorted by x, plus the
+// sorted distinct y coordinates they use.
+struct BoxSweep {
+    struct Event {
+        double x;
+        double y0;
+        double y1;
+        int delta;
+    };
+
+    std::vector<Event> events;
+    std::vector<double> ys;
+
+    BoxSweep(const std::vector<AxisBox>& boxes, double x_lo, double x_hi) {
+        events.reserve(boxes.size() * 2);
+        ys.reserve(boxes.size() * 2);
+        for (const auto& box : boxes) {
+            const auto left = std::max(box.min_x, x_lo);
+            const auto right = std::min(box.max_x, x_hi);
+            if (left >= right) {
+                continue;
+            }
+            events.push_back(Event{left, box.min_y, box.max_y, 1});
+            events.push_back(Event{right, box.min_y, box.max_y, -1});
+            ys.push_back(box.min_y);
+            ys.push_back(box.max_y);
+        }
+        std::sort(ys.begin(), ys.end());
+        ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+        std::sort(events.begin(), events.end(),
+                  [](const Event& lhs, const Event& rhs) { return lhs.x < rhs.x; });
+    }
+};
+
+// How many events or slabs a sweep handles between two stop checks.
+inline constexpr std::size_t kStopCheckInterval = 4096;
+
+inline double box_union_area(const std::vector<AxisBox>& boxes, double x_lo, double x_hi,
+                             const std::stop_token& stop) {
+    BoxSweep sweep{boxes, x_lo, x_hi};
+    if (sweep.events.empty()) {
+        return 0.0;
+    }
+    CoverageTree tree{std::move(sweep.ys)};
+    double area = 0.0;
+    double previous_x = sweep.events.front().x;
+    for (std::size_t i = 0; i < sweep.events.size(); ++i) {
+        if (i % kStopCheckInterval == 0 && stop.stop_requested()) {
+            break;
+        }
+        const auto& event = sweep.events[i];
+        area += tree.covered() * (event.x - previous_x);
+        previous_x = event.x;
+        tree.update(tree.index_of(event.y0), tree.index_of(event.y1), event.delta);
+    }
+    return area;
+}
+
+// Slab boundaries: every vertex abscissa plus every abscissa where two edges
+// cross. Between two consecutive boundaries the vertical order of the edges
+// is fixed, so the covered length is linear in x.
+inline std::vector<double> slab_boundaries(const std::vector<SweepEdge>& edges) {
+    std::vector<double> xs;
+    xs.reserve(edges.size() * 2);
+    for (const auto& edge : edges) {
+        xs.push_back(edge.x0);
+        xs.push_back(edge.x1);
+    }
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        const auto& lhs = edges[i];
+        for (std::size_t j = i + 1; j < edges.size() && edges[j].x0 < lhs.x1; ++j) {
+            const auto& rhs = edges[j];
+            const auto lo = std::max(lhs.x0, rhs.x0);
+            const auto hi = std::min(lhs.x1, rhs.x1);
+            if (lo >= hi) {
+                continue;
+            }
+            const auto d_lo = lhs.y_at(lo) - rhs.y_at(lo);
+            const auto d_hi = lhs.y_at(hi) - rhs.y_at(hi);
+            if ((d_lo < 0.0 && d_hi > 0.0) || (d_lo > 0.0 && d_hi < 0.0)) {
+                xs.push_back(lo + (hi - lo) * (d_lo / (d_lo - d_hi)));
+            }
+        }
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    return xs;
+}
+
+// Area of the union of boxes and general outlines over slabs
+// [first_slab, last_slab). `xs` holds every box abscissa and every slab
+// boundary of `edges`, so inside a slab the boxes covering it are fixed and
+// the general edges keep their vertical order. The boxes stay in the
+// coverage tree; each interval the edges cover adds its own length minus the
+// part the boxes already cover, integrated exactly from the tree's moments.
+// The active edges carry their order over from the previous slab: it only
+// changes by the edges that start, end or cross at the shared boundary, so
+// an insertion sort restores it in O(a) plus one step per crossing.
+inline double slab_union_area(const std::vector<AxisBox>& boxes, const std::vector<SweepEdge>& edges,
+                              const std::vector<double>& xs, std::size_t first_slab, std::size_t last_slab,
+                              const std::stop_token& stop) {
+    struct Crossing {
+        const SweepEdge* edge;
+        double y;
+    };
+
+    BoxSweep sweep{boxes, xs[first_slab], xs[last_slab]};
+    CoverageTree tree{std::move(sweep.ys)};
+    std::size_t next_event = 0;
+    // Edges spanning the current slab, bottom to top.
+    std::vector<Crossing> active;
+    std::size_t next_edge = 0;
+    double area = 0.0;
+
+    for (std::size_t slab = first_slab; slab < last_slab; ++slab) {
+        if ((slab - first_slab) % kStopCheckInterval == 0 && stop.stop_requested()) {
+            break;
+        }
+        const auto xa = xs[slab];
+        const auto xb = xs[slab + 1];
+        for (; next_event < sweep.events.size() && sweep.events[next_event].x <= xa; ++next_event) {
+            const auto& event = sweep.events[next_event];
+            tree.update(tree.index_of(event.y0), tree.index_of(event.y1), event.delta);
+        }
+        while (next_edge < edges.size() && edges[next_edge].x0 <= xa) {
+            active.push_back(Crossing{&edges[next_edge++], 0.0});
+        }
+        std::erase_if(active, [xa](const Crossing& crossing) { return crossing.edge->x1 <= xa; });
+
+        double length = tree.covered();
+        if (!active.empty()) {
+            const auto middle = xa + (xb - xa) / 2.0;
+            for (auto& crossing : active) {
+                crossing.y = crossing.edge->y_at(middle);
+            }
+            for (std::size_t i = 1; i < active.size(); ++i) {
+                const auto crossing = active[i];
+                auto j = i;
+                for (; j > 0 && crossing.y < active[j - 1].y; --j) {
+                    active[j] = active[j - 1];
+                }
+                active[j] = crossing;
+            }
+
+            int coverage = 0;
+            for (std::size_t i = 0; i + 1 < active.size(); ++i) {
+                coverage += active[i].edge->winding;
+                if (coverage <= 0) {
+                    continue;
+                }
+                const auto* bottom = active[i].edge;
+                const auto* top = active[i + 1].edge;
+                length += active[i + 1].y - active[i].y;
+                length -= tree.mean_covered_below(top->y_at(xa), top->y_at(xb)) -
+                          tree.mean_covered_below(bottom->y_at(xa), bottom->y_at(xb));
+            }
+        }
+        area += length * (xb - xa);
+    }
+    return area;
+}
+
+// Boxes, general edges sorted by their left end, and the slab boundaries of
+// both, gathered once from a collection.
+struct UnionSweep {
+    std::vector<AxisBox> boxes;
+    std::vector<SweepEdge> edges;
+    std::vector<double> xs;
+
+    [[nodiscard]] std::size_t slab_count() const noexcept { return xs.size() < 2 ? 0 : xs.size() - 1; }
+
+    [[nodiscard]] double strip_area(std::size_t first, std::size_t last, const std::stop_token& stop) const {
+        if (edges.empty()) {
+            return box_union_area(boxes, xs[first], xs[last], stop);
+        }
+        return slab_union_area(boxes, edges, xs, first, last, stop);
+    }
+};
+
+template <Scalar T>
+UnionSweep prepare_union(const Array<std::shared_ptr<Figure<T>>>& figures) {
+    UnionSweep sweep;
+    for (const auto& figure : figures) {
+        if (!figure) {
+            continue;
+        }
+        AxisBox box;
+        if (as_axis_box(*figure, box)) {
+            sweep.boxes.push_back(box);
+        } else {
+            append_edges(*figure, sweep.edges);
+        }
+    }
+
+    if (!sweep.edges.empty()) {
+        std::sort(sweep.edges.begin(), sweep.edges.end(),
+                  [](const SweepEdge& lhs, const SweepEdge& rhs) { return lhs.x0 < rhs.x0; });
+        sweep.xs = slab_boundaries(sweep.edges);
+    }
+    sweep.xs.reserve(sweep.xs.size() + sweep.boxes.size() * 2);
+    for (const auto& box : sweep.boxes) {
+        sweep.xs.push_back(box.min_x);
+        sweep.xs.push_back(box.max_x);
+    }
+    std::sort(sweep.xs.begin(), sweep.xs.end());
+    sweep.xs.erase(std::unique(sweep.xs.begin(), sweep.xs.end()), sweep.xs.end());
+    return sweep;
+}
+
+}  // namespace detail
+
+// Area covered by the union of all figures: overlapping regions are counted
+// once. Axis-aligned rectangles go into a coverage segment tree swept in
+// O(n log n); any other outline is split into trapezoid slabs at its vertices
+// and at the crossings of its edges, and the two are merged in one sweep.
+// Only the other outlines pay for the slabs, and they make the whole call
+// superlinear: with e such edges, at most a of them spanning any abscissa,
+// finding the crossings compares every pair whose x ranges overlap, O(e a),
+// which is O(e^2) at worst; the s >= e slabs, one more per crossing, each
+// walk their a edges and look the boxes up in the tree. A collection of n
+// boxes costs O(n log n + s log s + e a + s a log n) in total.
+//
+// This overload splits the plane into vertical strips swept as tasks on
+// `pool` and polls `stop` while sweeping; it returns std::nullopt once a stop
+// was requested.
+template <Scalar T>
+std::optional<double> union_area(const Array<std::shared_ptr<Figure<T>>>& figures, ThreadPool& pool,
+                                 std::stop_token stop = {}) {
+    const auto sweep = detail::prepare_union(figures);
+    const auto slab_count = sweep.slab_count();
+    // A few strips per thread so that stealing evens out uneven strips.
+    const auto strips = std::max<std::size_t>(1, std::min(slab_count, pool.size() * 4));
+    std::vector<double> partial(strips, 0.0);
+    if (slab_count > 0) {
+        pool.parallel_for(strips, 1, [&](std::size_t first, std::size_t last) {
+            for (auto strip = first; strip < last; ++strip) {
+                partial[strip] =
+                    sweep.strip_area(slab_count * strip / strips, slab_count * (strip + 1) / strips, stop);
+            }
+        });
+    }
+    if (stop.stop_requested()) {
+        return std::nullopt;
+    }
+    double total = 0.0;
+    for (const auto value : partial) {
+        total += value;
+    }
+    return total;
+}
+
+// Sweeps on the calling thread, or with thread_count > 1 (0 means hardware
+// concurrency) on a pool of that many threads made for the call.
+template <Scalar T>
+double union_area(const Array<std::shared_ptr<Figure<T>>>& figures, std::size_t thread_count = 1) {
+    if (thread_count == 1) {
+        const auto sweep = detail::prepare_union(figures);
+        return sweep.slab_count() == 0 ? 0.0 : sweep.strip_area(0, sweep.slab_count(), {});
+    }
+    ThreadPool pool{thread_count};
+    return *union_area(figures, pool);
+}
+
+}  // namespace lab04
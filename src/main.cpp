@@ -1,18 +1,45 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "../include/array.hpp"
+#include "../include/enclosing.hpp"
+#include "../include/figure_views.hpp"
+#include "../include/ingest.hpp"
+#include "../include/instrumentation.hpp"
+#include "../include/journal.hpp"
+#include "../include/raster.hpp"
 #include "../include/rectangle.hpp"
+#include "../include/runtime_polygon.hpp"
+#include "../include/server.hpp"
+#include "../include/shared_store.hpp"
+#include "../include/spatial_order.hpp"
 #include "../include/square.hpp"
+#include "../include/task_executor.hpp"
 #include "../include/triangle.hpp"
+#include "../include/union_area.hpp"
 
 namespace {
 
 using lab04::Array;
 using lab04::Figure;
 using lab04::Point;
+using lab04::Polygon;
 using lab04::Rectangle;
 using lab04::Square;
 using lab04::Triangle;
@@ -62,6 +89,17 @@ std::shared_ptr<Figure<T>> create_rectangle() {
     return std::make_shared<Rectangle<T>>(center, width, height);
 }
 
+template <lab04::Scalar T>
+std::shared_ptr<Figure<T>> create_polygon() {
+    const auto count = read_value<std::size_t>("Введите число вершин многоугольника: ");
+    std::vector<Point<T>> points;
+    points.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        points.push_back(read_point<T>("Вершина " + std::to_string(i + 1)));
+    }
+    return std::make_shared<Polygon<T>>(std::move(points));
+}
+
 void print_menu() {
     std::cout << "\nМеню:\n"
               << "1. Добавить треугольник\n"
@@ -73,53 +111,292 @@ void print_menu() {
               << "7. Удалить фигуру по индексу\n"
               << "8. Показать емкость и размер массива\n"
               << "9. Демонстрация шаблона массива\n"
+              << "10. Загрузить фигуры из файла\n"
+              << "11. Показать фоновые задачи\n"
+              << "12. Отменить фоновую задачу\n"
+              << "13. Добавить многоугольник\n"
+              << "14. Показать задержки операций\n"
+              << "15. Выпуклая оболочка и минимальная описанная окружность\n"
+              << "16. Упорядочить фигуры по Z-кривой\n"
+              << "17. Сохранить изображение фигур (PGM/PPM)\n"
+              << "18. Скопировать фигуры в разделяемую память\n"
               << "0. Выход\n";
 }
 
+constexpr std::size_t kReportChunk = 1024;
+
 template <lab04::Scalar T>
-void print_figures(const Array<std::shared_ptr<Figure<T>>>& figures) {
+void print_figures(const Array<std::shared_ptr<Figure<T>>>& figures, lab04::BackgroundTask& task) {
     if (figures.empty()) {
-        std::cout << "Массив фигур пуст.\n";
+        task.append_output("Массив фигур пуст.\n");
         return;
     }
-    for (std::size_t i = 0; i < figures.size(); ++i) {
-        const auto& figure = figures[i];
-        std::cout << i << ": ";
-        if (figure) {
-            std::cout << *figure << '\n';
-        } else {
-            std::cout << "<пусто>\n";
+    task.set_total(figures.size());
+    for (std::size_t first = 0; first < figures.size() && !task.stop_requested(); first += kReportChunk) {
+        const auto last = std::min(figures.size(), first + kReportChunk);
+        std::ostringstream out;
+        for (std::size_t i = first; i < last; ++i) {
+            const auto& figure = figures[i];
+            out << i << ": ";
+            if (figure) {
+                out << *figure << '\n';
+            } else {
+                out << "<пусто>\n";
+            }
         }
+        task.append_output(out.str());
+        task.advance(last - first);
     }
 }
 
 template <lab04::Scalar T>
-void print_centers(const Array<std::shared_ptr<Figure<T>>>& figures) {
+void print_centers(const Array<std::shared_ptr<Figure<T>>>& figures, lab04::BackgroundTask& task) {
     if (figures.empty()) {
-        std::cout << "Массив фигур пуст.\n";
+        task.append_output("Массив фигур пуст.\n");
         return;
     }
-    for (std::size_t i = 0; i < figures.size(); ++i) {
-        const auto& figure = figures[i];
-        std::cout << i << ": ";
-        if (figure) {
-            std::cout << "центр = " << figure->center()
-                      << ", площадь = " << figure->area() << '\n';
-        } else {
-            std::cout << "<пусто>\n";
+    task.set_total(figures.size());
+    for (std::size_t first = 0; first < figures.size() && !task.stop_requested(); first += kReportChunk) {
+        const auto last = std::min(figures.size(), first + kReportChunk);
+        std::ostringstream out;
+        for (std::size_t i = first; i < last; ++i) {
+            const auto& figure = figures[i];
+            out << i << ": ";
+            if (figure) {
+                out << "центр = " << figure->center()
+                    << ", площадь = " << figure->area() << '\n';
+            } else {
+                out << "<пусто>\n";
+            }
         }
+        task.append_output(out.str());
+        task.advance(last - first);
     }
 }
 
 template <lab04::Scalar T>
-double total_area(const Array<std::shared_ptr<Figure<T>>>& figures) {
+void print_total_area(const Array<std::shared_ptr<Figure<T>>>& figures, lab04::BackgroundTask& task,
+                      lab04::ThreadPool& pool) {
+    std::vector<double> partial((figures.size() + kReportChunk - 1) / kReportChunk, 0.0);
+    task.set_total(figures.size());
+    const auto areas = figures | lab04::views::areas;
+    pool.parallel_for(figures.size(), kReportChunk, [&](std::size_t first, std::size_t last) {
+        if (task.stop_requested()) {
+            return;
+        }
+        double sum = 0.0;
+        for (const auto value : std::ranges::subrange(areas.begin() + first, areas.begin() + last)) {
+            sum += value;
+        }
+        partial[first / kReportChunk] = sum;
+        task.advance(last - first);
+    });
+
     double total = 0.0;
+    for (const auto value : partial) {
+        total += value;
+    }
+    std::ostringstream out;
+    if (task.stop_requested()) {
+        out << "Частичная суммарная площадь = " << total << '\n';
+        task.append_output(out.str());
+        return;
+    }
+    out << "Суммарная площадь = " << total << '\n';
+    task.append_output(out.str());
+
+    out.str({});
+    const auto covered = lab04::union_area(figures, pool, task.get_stop_token());
+    if (covered) {
+        out << "Площадь покрытия (без наложений) = " << *covered << '\n';
+    } else {
+        out << "Вычисление площади покрытия прервано.\n";
+    }
+    task.append_output(out.str());
+}
+
+template <lab04::Scalar T>
+void print_hull_and_circle(const Array<std::shared_ptr<Figure<T>>>& figures, lab04::ThreadPool& pool,
+                           lab04::BackgroundTask& task) {
+    const auto hull = lab04::convex_hull(figures, pool);
+    std::ostringstream out;
+    if (hull.empty()) {
+        out << "Массив фигур пуст.\n";
+        task.append_output(out.str());
+        return;
+    }
+    out << "Выпуклая оболочка: " << hull.size() << " вершин";
+    if (hull.size() >= 3) {
+        out << ", площадь = " << Polygon<T>{hull}.area();
+    }
+    out << '\n';
+    const auto circle = lab04::min_enclosing_circle(std::span<const Point<T>>{hull});
+    out << "Минимальная описанная окружность: центр = " << circle.center << ", радиус = " << circle.radius
+        << '\n';
+    task.append_output(out.str());
+}
+
+template <lab04::Scalar T>
+void export_image(const Array<std::shared_ptr<Figure<T>>>& figures, const std::string& path,
+                  const lab04::RasterOptions& options, lab04::BackgroundTask& task, lab04::ThreadPool& pool) {
+    const auto rendered = lab04::rasterize(figures, options, pool, task.get_stop_token());
+    if (!rendered) {
+        task.append_output("Экспорт изображения прерван.\n");
+        return;
+    }
+    const auto& grid = *rendered;
+    std::ofstream out{path, std::ios::binary};
+    if (!out) {
+        task.append_output("Не удалось открыть файл " + path + "\n");
+        return;
+    }
+    if (path.ends_with(".ppm")) {
+        lab04::write_ppm(out, grid);
+    } else {
+        lab04::write_pgm(out, grid);
+    }
+    task.append_output("Изображение " + std::to_string(grid.width()) + "x" + std::to_string(grid.height()) +
+                       " сохранено в " + path + "\n");
+}
+
+const char* task_status_name(lab04::TaskStatus status) {
+    switch (status) {
+        case lab04::TaskStatus::Running:
+            return "выполняется";
+        case lab04::TaskStatus::Completed:
+            return "завершена";
+        case lab04::TaskStatus::Cancelled:
+            return "отменена";
+        case lab04::TaskStatus::Failed:
+            return "ошибка";
+    }
+    return "?";
+}
+
+void print_task_state(lab04::BackgroundTask& task) {
+    std::cout << task.take_output();
+    std::cout << "Задача #" << task.id() << " (" << task.name() << "): "
+              << task_status_name(task.status()) << ", готово "
+              << static_cast<int>(task.progress() * 100.0) << "%";
+    const auto error = task.error();
+    if (!error.empty()) {
+        std::cout << " — " << error;
+    }
+    std::cout << '\n';
+}
+
+void run_in_background(lab04::TaskExecutor& executor, std::string name,
+                       lab04::TaskExecutor::body_type body) {
+    const auto task = executor.launch(std::move(name), std::move(body));
+    if (task->wait_for(std::chrono::milliseconds(200))) {
+        std::cout << task->take_output();
+        if (task->status() == lab04::TaskStatus::Failed) {
+            std::cout << "Ошибка: " << task->error() << '\n';
+        }
+        executor.forget(task->id());
+        return;
+    }
+    print_task_state(*task);
+    std::cout << "Задача продолжает выполняться в фоне: пункт 11 — состояние, пункт 12 — отмена.\n";
+}
+
+void show_tasks(lab04::TaskExecutor& executor) {
+    const auto tasks = executor.tasks();
+    if (tasks.empty()) {
+        std::cout << "Фоновых задач нет.\n";
+        return;
+    }
+    for (const auto& task : tasks) {
+        const bool finished = task->finished();
+        print_task_state(*task);
+        if (finished) {
+            executor.forget(task->id());
+        }
+    }
+}
+
+void cancel_task(lab04::TaskExecutor& executor) {
+    const auto id = read_value<std::size_t>("Введите номер задачи: ");
+    const auto task = executor.find(id);
+    if (!task) {
+        std::cout << "Задача #" << id << " не найдена.\n";
+        return;
+    }
+    task->cancel();
+    std::cout << "Отмена задачи #" << id << " запрошена.\n";
+}
+
+template <lab04::Scalar T>
+void load_figures(Array<std::shared_ptr<Figure<T>>>& figures) {
+    std::string path;
+    std::cout << "Введите путь к файлу: ";
+    std::cin >> path;
+    std::ifstream input{path};
+    if (!input) {
+        std::cout << "Не удалось открыть файл " << path << '\n';
+        return;
+    }
+    const auto report = lab04::ingest_figures(input, figures);
+    std::cout << "Загружено фигур: " << report.accepted << '\n';
+    for (const auto& error : report.errors) {
+        std::cout << "  строка " << error.line << ": " << error.message << '\n';
+    }
+}
+
+// Opens the shared store, attaching to the named one left by an earlier
+// run. Called before any thread is started, since the store forks its
+// worker spawner; a store that cannot be opened only disables item 18.
+template <lab04::Scalar T>
+void open_shared_store(std::optional<lab04::SharedFigureStore<T>>& store, const std::optional<std::string>& name) {
+    lab04::SharedStoreOptions options;
+    if (name) {
+        options.name = *name;
+        options.mode = lab04::SharedStoreMode::OpenOrCreate;
+    }
+    try {
+        store.emplace(options);
+        if (!store->created()) {
+            std::cout << "Подключено к хранилищу " << *name << ", фигур в нём: " << store->size() << '\n';
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Общее хранилище недоступно: " << ex.what() << '\n';
+    }
+}
+
+// Brings the shared store in line with the collection: figures not yet
+// published are copied, published ones no longer in the collection are
+// erased, and the shard workers sum the areas.
+template <lab04::Scalar T>
+void publish_to_shared_store(
+    const Array<std::shared_ptr<Figure<T>>>& figures, std::optional<lab04::SharedFigureStore<T>>& store,
+    std::unordered_map<std::shared_ptr<Figure<T>>, lab04::SharedFigureHandle>& published) {
+    if (!store) {
+        std::cout << "Общее хранилище недоступно.\n";
+        return;
+    }
+    std::unordered_map<std::shared_ptr<Figure<T>>, lab04::SharedFigureHandle> current;
+    std::size_t copied = 0;
     for (const auto& figure : figures) {
-        if (figure) {
-            total += figure->area();
+        if (!figure || current.contains(figure)) {
+            continue;
+        }
+        const auto it = published.find(figure);
+        if (it != published.end()) {
+            current.emplace(figure, it->second);
+            published.erase(it);
+        } else {
+            current.emplace(figure, store->insert(*figure));
+            ++copied;
         }
     }
-    return total;
+    for (const auto& [figure, handle] : published) {
+        store->erase(handle);
+    }
+    const auto removed = published.size();
+    published = std::move(current);
+    std::cout << "Скопировано фигур: " << copied << ", удалено: " << removed << ", всего в хранилище: "
+              << store->size() << ", суммарная площадь по процессам-обработчикам = " << store->total_area()
+              << '\n';
 }
 
 void demonstrate_array_templates() {
@@ -138,11 +415,165 @@ void demonstrate_array_templates() {
               << squares[0].area() << '\n';
 }
 
+std::atomic<lab04::FigureServer<double>*> active_server{nullptr};
+
+void stop_active_server(int) {
+    if (auto* server = active_server.load()) {
+        server->stop();
+    }
+}
+
+int serve(Array<std::shared_ptr<Figure<double>>>& figures, lab04::FigureJournal<double>* journal,
+          const std::string& endpoint) {
+    try {
+        // UNION replies are computed here, off the event loop; declared first
+        // so it finishes pending jobs after the server is gone.
+        lab04::ThreadPool pool;
+        lab04::FigureService<double> service{figures, journal};
+        lab04::FigureServer<double> server{service, endpoint, {}, &pool};
+        active_server = &server;
+        std::signal(SIGINT, stop_active_server);
+        std::signal(SIGTERM, stop_active_server);
+        std::cout << "Сервер слушает " << endpoint;
+        if (server.port() != 0) {
+            std::cout << " (порт " << server.port() << ')';
+        }
+        std::cout << std::endl;
+        server.run();
+        active_server = nullptr;
+    } catch (const std::exception& ex) {
+        active_server = nullptr;
+        std::cerr << "Ошибка сервера: " << ex.what() << '\n';
+        return 1;
+    }
+    if (journal) {
+        try {
+            journal->snapshot(figures);
+        } catch (const std::exception& ex) {
+            std::cerr << "Не удалось сохранить снимок: " << ex.what() << '\n';
+        }
+    }
+    std::cout << "Сервер остановлен.\n";
+    return 0;
+}
+
+void show_latencies() {
+    if (!lab04::kInstrumentationEnabled) {
+        std::cout << "Сборка без инструментирования (LAB04_ENABLE_INSTRUMENTATION=OFF).\n";
+        return;
+    }
+    lab04::Instrumentation::instance().dump_text(std::cout);
+}
+
+void write_instrumentation(const std::optional<std::string>& stats_path,
+                           const std::optional<std::string>& trace_path) {
+    const auto& registry = lab04::Instrumentation::instance();
+    if (stats_path) {
+        std::ofstream out{*stats_path};
+        registry.dump_json(out);
+        if (!out) {
+            std::cerr << "Не удалось записать статистику в " << *stats_path << '\n';
+        }
+    }
+    if (trace_path) {
+        std::ofstream out{*trace_path};
+        registry.write_trace(out);
+        if (!out) {
+            std::cerr << "Не удалось записать трассировку в " << *trace_path << '\n';
+        }
+    }
+}
+
+// Menu actions only buffer journal records; a full group commits by itself
+// and this thread commits a partial one once it has waited commit_delay, so
+// records are not held back while the menu waits for input.
+template <lab04::Scalar T>
+std::jthread start_journal_flusher(lab04::FigureJournal<T>& journal) {
+    return std::jthread([&journal](std::stop_token stop) {
+        std::mutex mutex;
+        std::condition_variable_any wake;
+        std::unique_lock lock{mutex};
+        while (!stop.stop_requested()) {
+            wake.wait_for(lock, stop, journal.commit_delay(), [] { return false; });
+            try {
+                journal.commit_if_due();
+            } catch (const std::exception& ex) {
+                std::cerr << "Ошибка журнала: " << ex.what() << '\n';
+            }
+        }
+    });
+}
+
 }  // namespace
 
-int main() {
+int main(int argc, char* argv[]) {
     using value_type = double;
     Array<std::shared_ptr<Figure<value_type>>> figures;
+    std::optional<lab04::FigureJournal<value_type>> journal;
+    std::optional<std::string> serve_endpoint;
+    std::optional<std::string> stats_path;
+    std::optional<std::string> trace_path;
+    std::optional<std::string> store_name;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument{argv[i]};
+        if (argument == "--journal" && i + 1 < argc) {
+            journal.emplace(argv[++i]);
+        } else if (argument == "--serve" && i + 1 < argc) {
+            serve_endpoint = argv[++i];
+        } else if (argument == "--stats" && i + 1 < argc) {
+            stats_path = argv[++i];
+        } else if (argument == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (argument == "--store" && i + 1 < argc) {
+            store_name = argv[++i];
+        } else {
+            std::cerr << "Использование: " << argv[0]
+                      << " [--journal <каталог>] [--serve <путь к сокету | 127.0.0.1:порт>]"
+                      << " [--stats <файл.json>] [--trace <файл.json>] [--store </имя>]\n";
+            return 1;
+        }
+    }
+
+    if (journal) {
+        try {
+            const auto replayed = journal->recover(figures);
+            std::cout << "Восстановлено фигур: " << figures.size()
+                      << " (записей журнала: " << replayed << ")\n";
+        } catch (const std::exception& ex) {
+            std::cerr << "Не удалось восстановить журнал: " << ex.what() << '\n';
+            return 1;
+        }
+    }
+
+    if (trace_path) {
+        lab04::Instrumentation::instance().enable_trace(true);
+    }
+
+    if (serve_endpoint) {
+        const auto status = serve(figures, journal ? &*journal : nullptr, *serve_endpoint);
+        write_instrumentation(stats_path, trace_path);
+        return status;
+    }
+
+    const auto append_figure = [&](std::shared_ptr<Figure<value_type>> figure) {
+        figures.push_back(std::move(figure));
+        if (journal) {
+            journal->record_add(*figures.back());
+        }
+    };
+
+    // Before the first thread: the store forks its worker spawner here.
+    std::optional<lab04::SharedFigureStore<value_type>> shared_store;
+    open_shared_store(shared_store, store_name);
+    std::unordered_map<std::shared_ptr<Figure<value_type>>, lab04::SharedFigureHandle> published;
+
+    std::jthread journal_flusher;
+    if (journal) {
+        journal_flusher = start_journal_flusher(*journal);
+    }
+
+    lab04::TaskExecutor executor;
 
     bool running = true;
     while (running) {
@@ -150,33 +581,38 @@ int main() {
         const int choice = read_value<int>("Выберите пункт меню: ");
 
         try {
+            LAB04_TRACE_SCOPE_NAMED("menu." + std::to_string(choice));
             switch (choice) {
                 case 1: {
-                    auto figure = create_triangle<value_type>();
-                    figures.push_back(std::move(figure));
+                    append_figure(create_triangle<value_type>());
                     std::cout << "Треугольник добавлен.\n";
                     break;
                 }
                 case 2: {
-                    auto figure = create_square<value_type>();
-                    figures.push_back(std::move(figure));
+                    append_figure(create_square<value_type>());
                     std::cout << "Квадрат добавлен.\n";
                     break;
                 }
                 case 3: {
-                    auto figure = create_rectangle<value_type>();
-                    figures.push_back(std::move(figure));
+                    append_figure(create_rectangle<value_type>());
                     std::cout << "Прямоугольник добавлен.\n";
                     break;
                 }
                 case 4:
-                    print_figures(figures);
+                    run_in_background(executor, "вывод фигур", [figures](lab04::BackgroundTask& task) {
+                        print_figures(figures, task);
+                    });
                     break;
                 case 5:
-                    std::cout << "Суммарная площадь = " << total_area(figures) << '\n';
+                    run_in_background(executor, "суммарная площадь",
+                                      [figures, &executor](lab04::BackgroundTask& task) {
+                                          print_total_area(figures, task, executor.pool());
+                                      });
                     break;
                 case 6:
-                    print_centers(figures);
+                    run_in_background(executor, "вывод центров", [figures](lab04::BackgroundTask& task) {
+                        print_centers(figures, task);
+                    });
                     break;
                 case 7: {
                     if (figures.empty()) {
@@ -185,6 +621,9 @@ int main() {
                     }
                     const auto index = read_value<std::size_t>("Введите индекс для удаления: ");
                     figures.erase(index);
+                    if (journal) {
+                        journal->record_erase(index);
+                    }
                     std::cout << "Фигура удалена.\n";
                     break;
                 }
@@ -195,6 +634,70 @@ int main() {
                 case 9:
                     demonstrate_array_templates();
                     break;
+                case 10: {
+                    const auto first_new = figures.size();
+                    // Figures appended before a failure stay in the collection,
+                    // so they are journaled whether or not the load completes.
+                    const auto journal_new = [&] {
+                        if (journal) {
+                            for (auto i = first_new; i < figures.size(); ++i) {
+                                journal->record_add(*figures[i]);
+                            }
+                        }
+                    };
+                    try {
+                        load_figures(figures);
+                    } catch (...) {
+                        journal_new();
+                        throw;
+                    }
+                    journal_new();
+                    break;
+                }
+                case 11:
+                    show_tasks(executor);
+                    break;
+                case 12:
+                    cancel_task(executor);
+                    break;
+                case 13: {
+                    append_figure(create_polygon<value_type>());
+                    std::cout << "Многоугольник добавлен.\n";
+                    break;
+                }
+                case 14:
+                    show_latencies();
+                    break;
+                case 15:
+                    run_in_background(executor, "оболочка и окружность",
+                                      [figures, &executor](lab04::BackgroundTask& task) {
+                                          print_hull_and_circle(figures, executor.pool(), task);
+                                      });
+                    break;
+                case 16:
+                    lab04::reorder_spatially(figures, executor.pool());
+                    if (journal) {
+                        // Journal records address figures by index; only a snapshot survives the permutation.
+                        journal->snapshot(figures);
+                    }
+                    std::cout << "Фигуры упорядочены по Z-кривой.\n";
+                    break;
+                case 17: {
+                    std::string path;
+                    std::cout << "Введите путь к файлу (.pgm или .ppm): ";
+                    std::cin >> path;
+                    lab04::RasterOptions options;
+                    options.width = read_value<std::size_t>("Ширина изображения: ");
+                    options.height = read_value<std::size_t>("Высота изображения: ");
+                    run_in_background(executor, "экспорт изображения",
+                                      [figures, path, options, &executor](lab04::BackgroundTask& task) {
+                                          export_image(figures, path, options, task, executor.pool());
+                                      });
+                    break;
+                }
+                case 18:
+                    publish_to_shared_store(figures, shared_store, published);
+                    break;
                 case 0:
                     running = false;
                     break;
@@ -202,11 +705,23 @@ int main() {
                     std::cout << "Неизвестный пункт меню.\n";
                     break;
             }
+            if (journal) {
+                journal->maybe_snapshot(figures);
+            }
         } catch (const std::exception& ex) {
             std::cout << "Ошибка: " << ex.what() << '\n';
         }
     }
 
+    if (journal) {
+        try {
+            journal->snapshot(figures);
+        } catch (const std::exception& ex) {
+            std::cerr << "Не удалось сохранить снимок: " << ex.what() << '\n';
+        }
+    }
+
+    write_instrumentation(stats_path, trace_path);
     std::cout << "Программа завершена.\n";
     return 0;
 }
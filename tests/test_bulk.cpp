@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/bulk.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/square.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::Point;
+using lab04::Rectangle;
+using lab04::Square;
+using lab04::Triangle;
+
+using Collection = Array<std::shared_ptr<Figure<double>>>;
+using Columns = std::vector<double>;
+
+TEST(BulkFactoryTest, MatchesConstructorsAndReportsBadRows) {
+    const Columns x{0.0, 1.5, -2.0, 7.25, 3.0};
+    const Columns y{0.0, -4.0, 2.0, 0.1, 3.0};
+    const Columns width{2.0, 0.0, 3.0, NAN, 0.3};
+    const Columns height{1.0, 1.0, -1.0, 2.0, 0.7};
+
+    Collection figures;
+    figures.push_back(nullptr);
+    const auto squares = lab04::append_squares<double>(figures, x, y, width);
+    const auto rectangles = lab04::append_rectangles<double>(figures, x, y, width, height);
+    const auto triangles = lab04::append_triangles<double>(figures, x, y, width, height);
+
+    EXPECT_EQ(squares.accepted, 3u);
+    EXPECT_EQ(squares.rejected, (std::vector<std::size_t>{1, 3}));
+    EXPECT_EQ(rectangles.accepted, 2u);
+    EXPECT_EQ(rectangles.rejected, (std::vector<std::size_t>{1, 2, 3}));
+    EXPECT_EQ(triangles.rejected, rectangles.rejected);
+    ASSERT_EQ(figures.size(), 8u);
+
+    const Square<double> square{Point<double>{3.0, 3.0}, 0.3};
+    const Rectangle<double> rectangle{Point<double>{3.0, 3.0}, 0.3, 0.7};
+    const Triangle<double> triangle{Point<double>{3.0, 3.0}, 0.3, 0.7};
+    const Figure<double>* expected[] = {&square, &rectangle, &triangle};
+    const std::size_t built[] = {3, 5, 7};
+    for (std::size_t k = 0; k < 3; ++k) {
+        const auto& figure = *figures[built[k]];
+        EXPECT_TRUE(figure == *expected[k]);
+        for (std::size_t i = 0; i < figure.vertex_count(); ++i) {
+            EXPECT_EQ(figure.vertex(i).x(), expected[k]->vertex(i).x());
+            EXPECT_EQ(figure.vertex(i).y(), expected[k]->vertex(i).y());
+        }
+    }
+    EXPECT_NE(dynamic_cast<const Triangle<double>*>(figures[6].get()), nullptr);
+}
+
+TEST(BulkFactoryTest, SharesOneBlockThatOutlivesTheCollection) {
+    const Columns x{0.0, 10.0, 20.0};
+    const Columns y{0.0, 0.0, 0.0};
+    const Columns base{2.0, 4.0, 6.0};
+    const Columns height{3.0, 3.0, 3.0};
+
+    std::shared_ptr<Figure<double>> survivor;
+    {
+        Collection figures;
+        lab04::append_triangles<double>(figures, x, y, base, height);
+        EXPECT_EQ(figures[0].use_count(), figures[2].use_count());
+        survivor = figures[2];
+        auto copy = survivor->clone();
+        EXPECT_TRUE(*copy == *survivor);
+    }
+    EXPECT_DOUBLE_EQ(survivor->area(), 9.0);
+}
+
+TEST(BulkFactoryTest, RejectsColumnsOfDifferentLength) {
+    Collection figures;
+    const Columns two{1.0, 2.0};
+    const Columns three{1.0, 2.0, 3.0};
+    EXPECT_THROW(lab04::append_squares<double>(figures, two, two, three), std::invalid_argument);
+    EXPECT_TRUE(figures.empty());
+
+    const auto empty = lab04::append_squares<double>(figures, {}, {}, {});
+    EXPECT_EQ(empty.accepted, 0u);
+    EXPECT_TRUE(empty.rejected.empty());
+}
+
+}  // namespace
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/enclosing.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/runtime_polygon.hpp"
+#include "../include/square.hpp"
+#include "../include/task_executor.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Circle;
+using lab04::Figure;
+using lab04::Point;
+using lab04::Polygon;
+using lab04::Rectangle;
+using lab04::Square;
+using lab04::Triangle;
+
+using Collection = Array<std::shared_ptr<Figure<double>>>;
+
+Collection random_figures(std::size_t count, unsigned seed) {
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<double> coordinate{-100.0, 100.0};
+    std::uniform_real_distribution<double> size{0.5, 5.0};
+    Collection figures;
+    for (std::size_t i = 0; i < count; ++i) {
+        const Point<double> center{coordinate(rng), coordinate(rng)};
+        switch (i % 3) {
+            case 0:
+                figures.push_back(std::make_shared<Square<double>>(center, size(rng)));
+                break;
+            case 1:
+                figures.push_back(std::make_shared<Rectangle<double>>(center, size(rng), size(rng)));
+                break;
+            default:
+                figures.push_back(std::make_shared<Triangle<double>>(center, size(rng), size(rng)));
+                break;
+        }
+    }
+    return figures;
+}
+
+TEST(CollectionHullTest, WrapsAllVerticesCounterClockwise) {
+    Collection figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{0.0, 0.0}, 2.0));
+    figures.push_back(nullptr);
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{10.0, 0.0}, 2.0));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{5.0, 0.0}, 1.0));
+
+    const auto hull = lab04::convex_hull(figures);
+    ASSERT_EQ(hull.size(), 4u);
+    EXPECT_DOUBLE_EQ(Polygon<double>{hull}.area(), 24.0);
+    EXPECT_EQ(lab04::orientation(hull[0], hull[1], hull[2]), 1);
+
+    EXPECT_TRUE(lab04::convex_hull(Collection{}).empty());
+}
+
+TEST(CollectionHullTest, ParallelMergeMatchesSerialHull) {
+    const auto figures = random_figures(3000, 7);
+    const auto serial = lab04::convex_hull(figures, 1);
+    const auto parallel = lab04::convex_hull(figures, 4);
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i].x(), parallel[i].x());
+        EXPECT_EQ(serial[i].y(), parallel[i].y());
+    }
+
+    lab04::ThreadPool pool{3};
+    const auto pooled = lab04::convex_hull(figures, pool);
+    ASSERT_EQ(serial.size(), pooled.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i].x(), pooled[i].x());
+        EXPECT_EQ(serial[i].y(), pooled[i].y());
+    }
+    const auto circle = lab04::min_enclosing_circle(figures, pool);
+    EXPECT_DOUBLE_EQ(circle.radius, lab04::min_enclosing_circle(figures).radius);
+}
+
+TEST(EnclosingCircleTest, FindsTheSmallestCircle) {
+    Collection figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{1.0, 1.0}, 2.0));
+    const auto square_circle = lab04::min_enclosing_circle(figures);
+    EXPECT_NEAR(square_circle.radius, std::sqrt(2.0), 1e-12);
+    EXPECT_NEAR(square_circle.center.x(), 1.0, 1e-12);
+    EXPECT_NEAR(square_circle.center.y(), 1.0, 1e-12);
+
+    const auto empty = lab04::min_enclosing_circle(Collection{});
+    EXPECT_EQ(empty.radius, 0.0);
+}
+
+TEST(EnclosingCircleTest, MatchesBruteForceOnRandomInput) {
+    const auto figures = random_figures(12, 3);
+    const auto circle = lab04::min_enclosing_circle(figures, 2);
+
+    std::vector<Point<double>> points;
+    for (const auto& figure : figures) {
+        for (std::size_t i = 0; i < figure->vertex_count(); ++i) {
+            points.push_back(figure->vertex(i));
+            EXPECT_TRUE(circle.contains(points.back(), 1e-9));
+        }
+    }
+
+    double best = INFINITY;
+    const auto consider = [&](const Circle& candidate) {
+        for (const auto& point : points) {
+            if (!candidate.contains(point, 1e-9)) {
+                return;
+            }
+        }
+        best = std::min(best, candidate.radius);
+    };
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        for (std::size_t j = i + 1; j < points.size(); ++j) {
+            consider(lab04::detail::circle_from(points[i], points[j]));
+            for (std::size_t k = j + 1; k < points.size(); ++k) {
+                consider(lab04::detail::circle_from(points[i], points[j], points[k]));
+            }
+        }
+    }
+    EXPECT_NEAR(circle.radius, best, 1e-9 * best);
+}
+
+}  // namespace
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/figure_views.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/square.hpp"
+#include "../include/task_executor.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::Point;
+using lab04::Rectangle;
+using lab04::SmallArray;
+using lab04::Square;
+using lab04::Triangle;
+namespace views = lab04::views;
+
+using FigureArray = Array<std::shared_ptr<Figure<double>>>;
+
+static_assert(std::ranges::contiguous_range<FigureArray>);
+static_assert(std::ranges::contiguous_range<SmallArray<std::shared_ptr<Figure<double>>, 8>>);
+static_assert(std::ranges::random_access_range<decltype(std::declval<FigureArray&>() | views::areas)>);
+static_assert(std::ranges::sized_range<decltype(std::declval<FigureArray&>() | views::centers)>);
+
+FigureArray make_figures() {
+    FigureArray figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{0.0, 0.0}, 2.0));
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>{5.0, 5.0}, 4.0, 3.0));
+    figures.push_back(nullptr);
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>{1.0, 1.0}, 2.0, 2.0));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{3.0, -1.0}, 5.0));
+    return figures;
+}
+
+TEST(FigureViewsTest, ByTypeYieldsOnlyMatchingShapes) {
+    const auto figures = make_figures();
+    std::vector<double> sides;
+    for (const auto& square : figures | views::by_type<Square<double>>) {
+        sides.push_back(square.side());
+    }
+    EXPECT_EQ(sides, (std::vector<double>{2.0, 5.0}));
+}
+
+TEST(FigureViewsTest, FiltersAndProjectionsCompose) {
+    const auto figures = make_figures();
+    std::vector<double> large;
+    for (const double area : figures | views::where_area_gt(4.0) | views::areas) {
+        large.push_back(area);
+    }
+    EXPECT_EQ(large, (std::vector<double>{12.0, 25.0}));
+
+    std::vector<Point<double>> centers;
+    for (const auto& center : figures | views::non_null | views::centers) {
+        centers.push_back(center);
+    }
+    ASSERT_EQ(centers.size(), 4u);
+    EXPECT_DOUBLE_EQ(centers[1].x(), 5.0);
+    EXPECT_DOUBLE_EQ(centers[1].y(), 5.0);
+}
+
+TEST(FigureViewsTest, AreasSupportIndexedParallelReduction) {
+    FigureArray figures;
+    for (int i = 1; i <= 1000; ++i) {
+        figures.push_back(std::make_shared<Square<double>>(Point<double>{0.0, 0.0}, 1.0));
+        if (i % 10 == 0) {
+            figures.push_back(nullptr);
+        }
+    }
+    const auto areas = figures | views::areas;
+    ASSERT_EQ(std::ranges::size(areas), figures.size());
+
+    lab04::ThreadPool pool{4};
+    std::vector<double> partial(figures.size(), 0.0);
+    pool.parallel_for(figures.size(), 64, [&](std::size_t first, std::size_t last) {
+        for (auto i = first; i < last; ++i) {
+            partial[i] = areas[i];
+        }
+    });
+    EXPECT_DOUBLE_EQ(std::accumulate(partial.begin(), partial.end(), 0.0), 1000.0);
+}
+
+}  // namespace
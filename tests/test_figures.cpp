@@ -93,6 +93,30 @@ TEST(SquareComparisonTest, EqualityDependsOnVertexCoordinates) {
     EXPECT_FALSE(reference == translated);
 }
 
+TEST(SquareCompactStorageTest, StoresOnlyCornersAndMaterializesVerticesOnDemand) {
+    static_assert(sizeof(Square<double>) <= sizeof(void*) + 4 * sizeof(double));
+    static_assert(sizeof(Rectangle<float>) <= sizeof(void*) + 4 * sizeof(float));
+
+    Square<double> square(Point<double>(1.0, 2.0), 2.0);
+    const auto vertices = square.vertices();
+    EXPECT_NEAR(vertices[0].x(), 0.0, kTolerance);
+    EXPECT_NEAR(vertices[0].y(), 1.0, kTolerance);
+    EXPECT_NEAR(vertices[2].x(), 2.0, kTolerance);
+    EXPECT_NEAR(vertices[2].y(), 3.0, kTolerance);
+    EXPECT_NEAR(square.side(), 2.0, kTolerance);
+    EXPECT_EQ(square.vertex_count(), 4U);
+    EXPECT_THROW(static_cast<void>(square.vertex(4)), std::out_of_range);
+}
+
+TEST(SquareCompactStorageTest, IntegralCoordinatesKeepTruncatedCorners) {
+    Square<int> square(Point<int>(0, 0), 3);
+
+    EXPECT_EQ(square.vertex(0).x(), -1);
+    EXPECT_EQ(square.vertex(2).x(), 1);
+    EXPECT_NEAR(square.area(), 4.0, kTolerance);
+    EXPECT_TRUE(square == Square<int>::from_vertices(square.vertices()));
+}
+
 TEST(RectangleGeometricPropertiesTest, ComputesAreaAndCenter) {
     Rectangle<double> rectangle(Point<double>(2.0, -2.0), 6.0, 4.0);
 
@@ -106,6 +130,17 @@ TEST(RectangleGeometricPropertiesTest, CircumscribedCircleUsesDiagonalLength) {
     EXPECT_NEAR(rectangle.circumscribed_circle_radius(), std::sqrt(52.0) / 2.0, kTolerance);
 }
 
+TEST(RectangleGeometricPropertiesTest, ClosedFormDimensionsMatchVertices) {
+    Rectangle<double> rectangle(Point<double>(-3.0, 5.0), 8.0, 6.0);
+
+    EXPECT_NEAR(rectangle.width(), 8.0, kTolerance);
+    EXPECT_NEAR(rectangle.height(), 6.0, kTolerance);
+    EXPECT_NEAR(rectangle.diagonal(), 10.0, kTolerance);
+    EXPECT_THROW((Rectangle<double>::from_vertices({Point<double>(0.0, 0.0), Point<double>(1.0, 0.5),
+                                                     Point<double>(1.0, 1.0), Point<double>(0.0, 1.0)})),
+                 std::invalid_argument);
+}
+
 TEST(FigureConversionTest, StaticCastToDoubleReturnsArea) {
     Square<double> square(Point<double>(0.0, 0.0), 3.0);
     const Figure<double>& figure = square;
@@ -154,6 +189,44 @@ TEST(ArrayStorageTest, EmplaceBackConstructsValueInPlace) {
     EXPECT_EQ(values[1].payload, -7);
 }
 
+TEST(ArrayStorageTest, GrowthPolicyControlsCapacitySteps) {
+    Array<int> doubling;
+    Array<int, lab04::HalfStepGrowth> half_step;
+    Array<int, lab04::ChunkGrowth<16>> chunked;
+    for (int i = 0; i < 5; ++i) {
+        doubling.push_back(i);
+        half_step.push_back(i);
+        chunked.push_back(i);
+    }
+
+    EXPECT_EQ(doubling.capacity(), 8U);
+    EXPECT_EQ(half_step.capacity(), 6U);
+    EXPECT_EQ(chunked.capacity(), 16U);
+}
+
+TEST(ArrayStorageTest, ShrinkToFitReleasesUnusedCapacity) {
+    Array<int> values;
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(i);
+    }
+    for (int i = 0; i < 90; ++i) {
+        values.pop_back();
+    }
+    values.shrink_to_fit();
+    EXPECT_EQ(values.capacity(), 10U);
+    EXPECT_EQ(values[9], 9);
+
+    values.reserve_exact(4);
+    EXPECT_EQ(values.capacity(), 10U);
+    values.reserve_exact(12);
+    EXPECT_EQ(values.capacity(), 12U);
+
+    values.clear();
+    values.shrink_to_fit();
+    EXPECT_EQ(values.capacity(), 0U);
+    EXPECT_EQ(values.data(), nullptr);
+}
+
 TEST(ArrayStorageTest, StoresSharedPointersToAbstractFigures) {
     Array<std::shared_ptr<Figure<double>>> figures;
     figures.push_back(std::make_shared<Square<double>>(Point<double>(0.0, 0.0), 2.0));
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/hit_test.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/runtime_polygon.hpp"
+#include "../include/square.hpp"
+#include "../include/task_executor.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::HitTestIndex;
+using lab04::Point;
+using lab04::Polygon;
+using lab04::Rectangle;
+using lab04::Square;
+using lab04::Triangle;
+
+TEST(FigureContainsTest, SquareIncludesInteriorAndBoundary) {
+    Square<double> square(Point<double>(0.0, 0.0), 2.0);
+
+    EXPECT_TRUE(square.contains(Point<double>(0.0, 0.0)));
+    EXPECT_TRUE(square.contains(Point<double>(1.0, 0.5)));
+    EXPECT_TRUE(square.contains(Point<double>(-1.0, -1.0)));
+    EXPECT_FALSE(square.contains(Point<double>(1.01, 0.0)));
+}
+
+TEST(FigureContainsTest, TriangleExcludesPointsOutsideSlantedEdges) {
+    Triangle<double> triangle(Point<double>(0.0, 0.0), 6.0, 3.0);
+
+    EXPECT_TRUE(triangle.contains(Point<double>(0.0, 1.5)));
+    EXPECT_TRUE(triangle.contains(Point<double>(2.5, -0.9)));
+    EXPECT_FALSE(triangle.contains(Point<double>(2.5, 1.0)));
+    EXPECT_FALSE(triangle.contains(Point<double>(0.0, -1.5)));
+}
+
+TEST(HitTestIndexTest, QueryReturnsAllContainingFiguresInIndexOrder) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(0.0, 0.0), 4.0));
+    figures.push_back(nullptr);
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>(1.0, 0.0), 2.0, 1.0));
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>(10.0, 10.0), 2.0, 2.0));
+
+    const HitTestIndex<double> index{figures};
+    EXPECT_EQ(index.size(), 3U);
+    EXPECT_EQ(index.query(Point<double>(1.5, 0.0)), (std::vector<std::size_t>{0, 2}));
+    EXPECT_EQ(index.query(Point<double>(10.0, 10.0)), (std::vector<std::size_t>{3}));
+    EXPECT_TRUE(index.query(Point<double>(5.0, 5.0)).empty());
+}
+
+TEST(HitTestIndexTest, FollowsAppendsAndErasesLikeAFreshIndex) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(0.0, 0.0), 4.0));
+    HitTestIndex<double> index{figures};
+
+    // Enough appends to go through several grid rebuilds, some far outside
+    // the first grid, interleaved with erases that shift later indices.
+    for (int i = 0; i < 200; ++i) {
+        const auto offset = static_cast<double>(i % 20) * 3.0;
+        figures.push_back(std::make_shared<Square<double>>(Point<double>(offset, offset), 2.0 + i % 3));
+        index.push_back(figures.back());
+        if (i % 7 == 6) {
+            const auto victim = static_cast<std::size_t>(i * 13) % figures.size();
+            figures.erase(victim);
+            index.erase(victim);
+        }
+    }
+    figures.push_back(nullptr);
+    index.push_back(nullptr);
+
+    const HitTestIndex<double> fresh{figures};
+    EXPECT_EQ(index.size(), fresh.size());
+    for (int i = -2; i < 62; ++i) {
+        const Point<double> point(i * 1.0, i * 1.0 + 0.5);
+        EXPECT_EQ(index.query(point), fresh.query(point));
+    }
+    EXPECT_THROW(index.erase(figures.size()), std::out_of_range);
+}
+
+TEST(HitTestIndexTest, NonFiniteQueriesHitNothing) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(0.0, 0.0), 4.0));
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>(1.0, 0.0), 2.0, 1.0));
+
+    const HitTestIndex<double> index{figures};
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+    const auto inf = std::numeric_limits<double>::infinity();
+    EXPECT_TRUE(index.query(Point<double>(nan, 0.0)).empty());
+    EXPECT_TRUE(index.query(Point<double>(0.0, -inf)).empty());
+
+    const std::vector<Point<double>> points{{nan, nan}, {1.5, 0.0}, {inf, 0.0}};
+    const auto result = index.classify(points);
+    EXPECT_TRUE(result.hits(0).empty());
+    EXPECT_EQ(result.hits(1).size(), 2U);
+    EXPECT_TRUE(result.hits(2).empty());
+}
+
+// Five points of a circle joined every second one: the turns share a sign
+// but wind twice, and the even-odd rule leaves the inner pentagon out.
+std::vector<Point<double>> pentagram() {
+    std::vector<Point<double>> points;
+    for (int i = 0; i < 5; ++i) {
+        const auto angle = 1.5707963267948966 + 2.0 * 2.0 * 3.141592653589793 * i / 5.0;
+        points.emplace_back(std::cos(angle), std::sin(angle));
+    }
+    return points;
+}
+
+TEST(HitTestIndexTest, StarPolygonsKeepTheEvenOddRule) {
+    EXPECT_EQ(lab04::convex_orientation(pentagram()), 0);
+    const std::vector<Point<double>> with_collinear{{0.0, 0.0}, {1.0, 0.0}, {2.0, 0.0}, {1.0, 1.0}};
+    EXPECT_EQ(lab04::convex_orientation(with_collinear), 1);
+
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Polygon<double>>(pentagram()));
+    const HitTestIndex<double> index{figures};
+    const Point<double> center{0.0, 0.0};
+    const Point<double> tip{0.0, 0.8};
+    ASSERT_FALSE(figures[0]->contains(center));
+    ASSERT_TRUE(figures[0]->contains(tip));
+    EXPECT_TRUE(index.query(center).empty());
+    EXPECT_EQ(index.query(tip).size(), 1U);
+}
+
+TEST(HitTestIndexTest, BatchClassificationMatchesPerFigureContains) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    for (int i = 0; i < 50; ++i) {
+        const Point<double> center{(i * 7 % 13) * 1.5, (i * 5 % 11) * 1.5};
+        if (i % 2 == 0) {
+            figures.push_back(std::make_shared<Triangle<double>>(center, 3.0, 2.0));
+        } else {
+            figures.push_back(std::make_shared<Rectangle<double>>(center, 2.0, 3.0));
+        }
+    }
+    std::vector<Point<double>> points;
+    for (int i = 0; i < 500; ++i) {
+        points.emplace_back((i * 37 % 211) * 0.1 - 1.0, (i * 53 % 173) * 0.1 - 1.0);
+    }
+
+    const HitTestIndex<double> index{figures};
+    const auto single = index.classify(points);
+    const auto threaded = index.classify(points, 4);
+
+    ASSERT_EQ(single.query_count(), points.size());
+    ASSERT_EQ(threaded.query_count(), points.size());
+    EXPECT_EQ(single.figures, threaded.figures);
+    EXPECT_EQ(single.offsets, threaded.offsets);
+    lab04::ThreadPool pool{3};
+    const auto pooled = index.classify(points, pool);
+    EXPECT_EQ(single.figures, pooled.figures);
+    EXPECT_EQ(single.offsets, pooled.offsets);
+    for (std::size_t q = 0; q < points.size(); ++q) {
+        std::vector<std::size_t> expected;
+        for (std::size_t f = 0; f < figures.size(); ++f) {
+            if (figures[f]->contains(points[q])) {
+                expected.push_back(f);
+            }
+        }
+        const auto hits = single.hits(q);
+        EXPECT_EQ(std::vector<std::size_t>(hits.begin(), hits.end()), expected) << "query " << q;
+    }
+}
+
+}  // namespace
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/ingest.hpp"
+#include "../include/square.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::Point;
+using lab04::SpscQueue;
+using lab04::Square;
+using lab04::Triangle;
+
+constexpr double kTolerance = 1e-6;
+
+std::string squares(int count) {
+    std::ostringstream text;
+    for (int i = 0; i < count; ++i) {
+        text << "square " << i << " 0 1\n";
+    }
+    return text.str();
+}
+
+// Serves `text`, then fails the next read instead of reporting end of file.
+class FailingBuffer : public std::streambuf {
+public:
+    explicit FailingBuffer(std::string text) : text_(std::move(text)) {
+        setg(text_.data(), text_.data(), text_.data() + text_.size());
+    }
+
+protected:
+    int_type underflow() override { throw std::runtime_error("device lost"); }
+
+private:
+    std::string text_;
+};
+
+// Refuses to grow past a fixed capacity, standing in for an allocation
+// failure on the inserting thread.
+struct CappedGrowth {
+    static std::size_t next_capacity(std::size_t, std::size_t required) {
+        if (required > 100) {
+            throw std::bad_alloc();
+        }
+        return required;
+    }
+};
+
+TEST(SpscQueueTest, DeliversValuesInOrderUnderBackpressure) {
+    SpscQueue<int> queue{2};
+    constexpr int kCount = 10000;
+    std::vector<int> received;
+
+    std::thread producer([&] {
+        for (int i = 0; i < kCount; ++i) {
+            queue.push(i);
+        }
+        queue.close();
+    });
+    int value = 0;
+    while (queue.pop(value)) {
+        received.push_back(value);
+    }
+    producer.join();
+
+    ASSERT_EQ(received.size(), static_cast<std::size_t>(kCount));
+    for (int i = 0; i < kCount; ++i) {
+        EXPECT_EQ(received[i], i);
+    }
+}
+
+TEST(SpscQueueTest, PushGivesUpOnceClosed) {
+    SpscQueue<int> queue{2};
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    queue.close();
+    EXPECT_FALSE(queue.push(3));
+    int value = 0;
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(IngestPipelineTest, AppendsValidFiguresInInputOrder) {
+    std::istringstream input{
+        "# comment\n"
+        "square 0 0 2\n"
+        "\n"
+        "rectangle 1 1 2 4\n"
+        "triangle 0 0 6 4\n"
+        "triangle 0 3 -2 0 2 0\n"};
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(5.0, 5.0), 1.0));
+
+    const auto report = lab04::ingest_figures(input, figures, {.batch_size = 1, .queue_capacity = 2});
+
+    EXPECT_EQ(report.accepted, 4U);
+    EXPECT_TRUE(report.errors.empty());
+    ASSERT_EQ(figures.size(), 5U);
+    EXPECT_NEAR(figures[1]->area(), 4.0, kTolerance);
+    EXPECT_NEAR(figures[2]->area(), 8.0, kTolerance);
+    EXPECT_NEAR(figures[3]->area(), 12.0, kTolerance);
+    EXPECT_NE(dynamic_cast<const Triangle<double>*>(figures[4].get()), nullptr);
+}
+
+TEST(IngestPipelineTest, ReportsRejectedLinesWithLineNumbers) {
+    std::istringstream input{
+        "square 0 0 2\n"
+        "circle 0 0 1\n"
+        "square 0 0 -1\n"
+        "triangle 0 3 -2 0 5 0\n"
+        "rectangle 0 0 1\n"
+        "square 1 1 1\n"};
+    Array<std::shared_ptr<Figure<double>>> figures;
+
+    const auto report = lab04::ingest_figures(input, figures);
+
+    EXPECT_EQ(report.accepted, 2U);
+    ASSERT_EQ(report.errors.size(), 4U);
+    EXPECT_EQ(report.errors[0].line, 2U);
+    EXPECT_EQ(report.errors[1].line, 3U);
+    EXPECT_EQ(report.errors[2].line, 4U);
+    EXPECT_EQ(report.errors[3].line, 5U);
+    EXPECT_EQ(figures.size(), 2U);
+}
+
+TEST(IngestPipelineTest, LargeInputKeepsEveryRecord) {
+    constexpr int kCount = 5000;
+    std::istringstream input{squares(kCount)};
+    Array<std::shared_ptr<Figure<double>>> figures;
+
+    const auto report = lab04::ingest_figures(input, figures, {.batch_size = 64, .queue_capacity = 4});
+
+    EXPECT_EQ(report.accepted, static_cast<std::size_t>(kCount));
+    ASSERT_EQ(figures.size(), static_cast<std::size_t>(kCount));
+    EXPECT_NEAR(figures[kCount - 1]->center().x(), kCount - 1.0, kTolerance);
+}
+
+TEST(IngestPipelineTest, ReaderFailureStopsThePipelineAndIsRethrown) {
+    FailingBuffer buffer{squares(1000)};
+    std::istream input{&buffer};
+    input.exceptions(std::ios::badbit);
+    Array<std::shared_ptr<Figure<double>>> figures;
+
+    EXPECT_THROW(lab04::ingest_figures(input, figures, {.batch_size = 8, .queue_capacity = 2}),
+                 std::runtime_error);
+    EXPECT_LE(figures.size(), 1000U);
+}
+
+TEST(IngestPipelineTest, InsertionFailureReleasesBlockedStages) {
+    // Far more input than the queues hold: both stages are blocked on full
+    // queues when the insertion throws, and must give up instead of hanging.
+    std::istringstream input{squares(20000)};
+    Array<std::shared_ptr<Figure<double>>, CappedGrowth> figures;
+
+    EXPECT_THROW(lab04::ingest_figures(input, figures, {.batch_size = 16, .queue_capacity = 2}), std::bad_alloc);
+    EXPECT_EQ(figures.size(), 100U);
+}
+
+}  // namespace
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/instrumentation.hpp"
+
+namespace {
+
+using lab04::Instrumentation;
+using lab04::LatencyHistogram;
+using lab04::ScopedTimer;
+
+TEST(LatencyHistogramTest, BucketsAreContiguousAndBounded) {
+    for (std::uint64_t value = 0; value < 100000; ++value) {
+        const auto bucket = LatencyHistogram::bucket_of(value);
+        ASSERT_LE(value, LatencyHistogram::bucket_upper(bucket));
+        if (bucket > 0) {
+            ASSERT_GT(value, LatencyHistogram::bucket_upper(bucket - 1));
+        }
+    }
+    EXPECT_LT(LatencyHistogram::bucket_of(UINT64_MAX), LatencyHistogram::kBucketCount);
+    EXPECT_EQ(LatencyHistogram::bucket_upper(LatencyHistogram::bucket_of(UINT64_MAX)), UINT64_MAX);
+}
+
+TEST(LatencyHistogramTest, PercentilesStayWithinBucketPrecision) {
+    LatencyHistogram histogram{"test"};
+    for (std::uint64_t value = 1; value <= 10000; ++value) {
+        histogram.record(value * 100);
+    }
+    EXPECT_EQ(histogram.count(), 10000u);
+    EXPECT_EQ(histogram.min(), 100u);
+    EXPECT_EQ(histogram.max(), 1000000u);
+    EXPECT_NEAR(histogram.mean(), 500050.0, 1e-6);
+
+    const auto within = [](std::uint64_t actual, double expected) {
+        return static_cast<double>(actual) >= expected && static_cast<double>(actual) <= expected * 1.035;
+    };
+    EXPECT_TRUE(within(histogram.percentile(0.5), 500000.0));
+    EXPECT_TRUE(within(histogram.percentile(0.99), 990000.0));
+    EXPECT_TRUE(within(histogram.percentile(0.999), 999000.0));
+    EXPECT_EQ(histogram.percentile(1.0), 1000000u);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.percentile(0.5), 0u);
+}
+
+TEST(InstrumentationTest, ScopedTimersFeedRegistryDumpsAndTrace) {
+    auto& registry = Instrumentation::instance();
+    registry.reset();
+    registry.enable_trace(true, 3);
+    auto& histogram = registry.histogram("test.scope");
+    EXPECT_EQ(&histogram, &registry.histogram("test.scope"));
+
+    std::vector<std::jthread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 100; ++i) {
+                const ScopedTimer timer{histogram};
+            }
+        });
+    }
+    threads.clear();
+    registry.enable_trace(false);
+    EXPECT_EQ(histogram.count(), 400u);
+
+    std::ostringstream text;
+    registry.dump_text(text);
+    EXPECT_NE(text.str().find("test.scope"), std::string::npos);
+
+    std::ostringstream json;
+    registry.dump_json(json);
+    EXPECT_NE(json.str().find("\"test.scope\": {\"count\": 400"), std::string::npos);
+
+    std::ostringstream trace;
+    registry.write_trace(trace);
+    EXPECT_NE(trace.str().find("\"ph\": \"X\""), std::string::npos);
+    EXPECT_NE(trace.str().find("\"dropped_events\": 397"), std::string::npos);
+    registry.reset();
+}
+
+}  // namespace
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/journal.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/runtime_polygon.hpp"
+#include "../include/square.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::FigureJournal;
+using lab04::Point;
+using lab04::Polygon;
+using lab04::Rectangle;
+using lab04::Square;
+using lab04::Triangle;
+
+using Collection = Array<std::shared_ptr<Figure<double>>>;
+
+class JournalTest : public ::testing::Test {
+protected:
+    std::filesystem::path directory_;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        directory_ = std::filesystem::temp_directory_path() /
+                     ("lab04_journal_" + std::to_string(::getpid()) + "_" + info->name());
+        std::filesystem::remove_all(directory_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(directory_); }
+
+    static void expect_same(const Collection& actual, const Collection& expected) {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_TRUE(*actual[i] == *expected[i]) << "figure " << i;
+        }
+    }
+};
+
+TEST_F(JournalTest, ReplaysCommittedAddsAndErases) {
+    Collection figures;
+    {
+        FigureJournal<double> journal{directory_};
+        EXPECT_EQ(journal.recover(figures), 0U);
+        const auto add = [&](std::shared_ptr<Figure<double>> figure) {
+            figures.push_back(figure);
+            journal.record_add(*figure);
+        };
+        add(std::make_shared<Triangle<double>>(Point<double>(0.1, 0.2), 3.0, 1.7));
+        add(std::make_shared<Square<double>>(Point<double>(0.3, -0.7), 1.1));
+        add(std::make_shared<Rectangle<double>>(Point<double>(1.0 / 3.0, 2.0), 0.7, 5.0));
+        add(std::make_shared<Polygon<double>>(Polygon<double>{{0.0, 0.0}, {2.0, 0.0}, {1.0, 1.5}, {0.5, 3.0}}));
+        figures.erase(1);
+        journal.record_erase(1);
+        journal.commit();
+    }
+
+    Collection restored;
+    FigureJournal<double> journal{directory_};
+    EXPECT_EQ(journal.recover(restored), 5U);
+    expect_same(restored, figures);
+}
+
+TEST_F(JournalTest, SnapshotTruncatesLogAndKeepsState) {
+    Collection figures;
+    {
+        FigureJournal<double> journal{directory_, {.group_commit_records = 2, .snapshot_every = 3}};
+        journal.recover(figures);
+        for (int i = 0; i < 3; ++i) {
+            figures.push_back(std::make_shared<Square<double>>(Point<double>(i, i), 1.0 + i));
+            journal.record_add(*figures.back());
+        }
+        EXPECT_TRUE(journal.snapshot_due());
+        journal.maybe_snapshot(figures);
+        EXPECT_FALSE(journal.snapshot_due());
+        figures.push_back(std::make_shared<Triangle<double>>(Point<double>(5.0, 5.0), 2.0, 2.0));
+        journal.record_add(*figures.back());
+    }
+    EXPECT_LT(std::filesystem::file_size(directory_ / "journal.log"), 128U);
+
+    Collection restored;
+    FigureJournal<double> journal{directory_};
+    EXPECT_EQ(journal.recover(restored), 1U);
+    expect_same(restored, figures);
+}
+
+TEST_F(JournalTest, TornTailIsDiscardedOnRecovery) {
+    Collection figures;
+    {
+        FigureJournal<double> journal{directory_};
+        journal.recover(figures);
+        for (int i = 0; i < 2; ++i) {
+            figures.push_back(std::make_shared<Square<double>>(Point<double>(i, 0.0), 1.0));
+            journal.record_add(*figures.back());
+        }
+    }
+    {
+        std::ofstream log{directory_ / "journal.log", std::ios::binary | std::ios::app};
+        log << "garbage";
+    }
+
+    Collection restored;
+    {
+        FigureJournal<double> journal{directory_};
+        EXPECT_EQ(journal.recover(restored), 2U);
+        restored.push_back(std::make_shared<Square<double>>(Point<double>(9.0, 9.0), 1.0));
+        journal.record_add(*restored.back());
+    }
+
+    Collection again;
+    FigureJournal<double> journal{directory_};
+    EXPECT_EQ(journal.recover(again), 3U);
+    expect_same(again, restored);
+}
+
+TEST_F(JournalTest, UnappliableRecordIsReportedNotTruncated) {
+    {
+        Collection figures;
+        FigureJournal<double> journal{directory_};
+        journal.recover(figures);
+        figures.push_back(std::make_shared<Square<double>>(Point<double>(0.0, 0.0), 1.0));
+        journal.record_add(*figures.back());
+        // Sealed like any other record, but there is nothing at index 5.
+        journal.record_erase(5);
+        journal.record_add(*figures.back());
+    }
+    const auto log = directory_ / "journal.log";
+    const auto size = std::filesystem::file_size(log);
+
+    Collection restored;
+    FigureJournal<double> journal{directory_};
+    EXPECT_THROW(journal.recover(restored), std::runtime_error);
+    EXPECT_EQ(std::filesystem::file_size(log), size);
+}
+
+TEST_F(JournalTest, DegenerateRecordedFigureIsReportedAsCorruption) {
+    {
+        Collection figures;
+        FigureJournal<double> journal{directory_};
+        journal.recover(figures);
+    }
+    // A checksummed add record of a triangle that is not isosceles.
+    std::vector<char> record(lab04::detail::kRecordHeaderSize);
+    lab04::detail::put(record, static_cast<std::uint8_t>(lab04::detail::JournalOp::Add));
+    lab04::detail::put(record, static_cast<std::uint8_t>(lab04::detail::ShapeCode::Triangle));
+    lab04::detail::put(record, std::uint32_t{3});
+    for (const double value : {0.0, 5.0, -1.0, 0.0, 4.0, 0.0}) {
+        lab04::detail::put(record, value);
+    }
+    lab04::detail::seal_record(record, 0);
+    {
+        std::ofstream out{directory_ / "journal.log", std::ios::binary | std::ios::app};
+        out.write(record.data(), static_cast<std::streamsize>(record.size()));
+    }
+
+    Collection restored;
+    FigureJournal<double> journal{directory_};
+    EXPECT_THROW(journal.recover(restored), std::runtime_error);
+}
+
+TEST_F(JournalTest, CommitIfDueWaitsForTheDelay) {
+    Collection figures;
+    FigureJournal<double> journal{directory_, {.commit_delay = std::chrono::milliseconds{200}}};
+    journal.recover(figures);
+    EXPECT_FALSE(journal.commit_if_due());
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(0.0, 0.0), 1.0));
+    journal.record_add(*figures.back());
+    journal.record_erase(0);
+    EXPECT_FALSE(journal.commit_if_due());
+    EXPECT_EQ(journal.pending_records(), 2U);
+    std::this_thread::sleep_for(std::chrono::milliseconds{250});
+    EXPECT_TRUE(journal.commit_if_due());
+    EXPECT_EQ(journal.pending_records(), 0U);
+}
+
+TEST_F(JournalTest, RecordingRequiresRecoveryFirst) {
+    FigureJournal<double> journal{directory_};
+    journal.record_erase(0);
+    EXPECT_THROW(journal.commit(), std::logic_error);
+}
+
+}  // namespace
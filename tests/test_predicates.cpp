@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/predicates.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Point;
+using lab04::Triangle;
+
+// Exact sum of products of integers below 2^53 in magnitude, kept as
+// high * 2^52 + low with 0 <= low < 2^52; a portable stand-in for a 128-bit
+// integer, independent of the expansion arithmetic under test.
+class WideSum {
+public:
+    void add_product(std::int64_t lhs, std::int64_t rhs) {
+        // Splits at 2^26 with the low halves non-negative.
+        const auto lhs_high = lhs >> 26;
+        const auto lhs_low = lhs & kLowMask;
+        const auto rhs_high = rhs >> 26;
+        const auto rhs_low = rhs & kLowMask;
+        const auto middle = lhs_high * rhs_low + lhs_low * rhs_high;
+        high_ += lhs_high * rhs_high + (middle >> 26);
+        low_ += ((middle & kLowMask) << 26) + lhs_low * rhs_low;
+        high_ += low_ >> 52;
+        low_ &= (std::int64_t{1} << 52) - 1;
+    }
+
+    [[nodiscard]] int sign() const { return high_ != 0 ? (high_ > 0 ? 1 : -1) : (low_ != 0 ? 1 : 0); }
+
+private:
+    static constexpr std::int64_t kLowMask = (std::int64_t{1} << 26) - 1;
+    std::int64_t high_{0};
+    std::int64_t low_{0};
+};
+
+std::int64_t integer(double value) { return static_cast<std::int64_t>(value); }
+
+int wide_orientation(const Point<double>& a, const Point<double>& b, const Point<double>& c) {
+    WideSum det;
+    det.add_product(integer(b.x()) - integer(a.x()), integer(c.y()) - integer(a.y()));
+    det.add_product(-(integer(b.y()) - integer(a.y())), integer(c.x()) - integer(a.x()));
+    return det.sign();
+}
+
+int wide_compare_distance(const Point<double>& o, const Point<double>& p, const Point<double>& q) {
+    const auto px = integer(p.x()) - integer(o.x());
+    const auto py = integer(p.y()) - integer(o.y());
+    const auto qx = integer(q.x()) - integer(o.x());
+    const auto qy = integer(q.y()) - integer(o.y());
+    WideSum difference;
+    difference.add_product(px, px);
+    difference.add_product(py, py);
+    difference.add_product(-qx, qx);
+    difference.add_product(-qy, qy);
+    return difference.sign();
+}
+
+// Integer coordinates near 2^50 on almost-degenerate configurations: the
+// plain double evaluation rounds, the reference above does not.
+struct NearDegenerate {
+    std::vector<Point<double>> a, b, c;
+};
+
+NearDegenerate near_collinear(std::size_t count, unsigned seed) {
+    std::mt19937_64 rng{seed};
+    std::uniform_int_distribution<std::int64_t> coordinate{-(std::int64_t{1} << 50), std::int64_t{1} << 50};
+    std::uniform_int_distribution<std::int64_t> step{-(std::int64_t{1} << 20), std::int64_t{1} << 20};
+    std::uniform_int_distribution<std::int64_t> jitter{-1, 1};
+    NearDegenerate batch;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto x = coordinate(rng);
+        const auto y = coordinate(rng);
+        const auto dx = step(rng);
+        const auto dy = step(rng);
+        const auto k = step(rng) % 64;
+        batch.a.emplace_back(static_cast<double>(x), static_cast<double>(y));
+        batch.b.emplace_back(static_cast<double>(x + dx), static_cast<double>(y + dy));
+        batch.c.emplace_back(static_cast<double>(x + k * dx + jitter(rng)), static_cast<double>(y + k * dy + jitter(rng)));
+    }
+    return batch;
+}
+
+TEST(AlmostEqualTest, ComparesWithScaledTolerance) {
+    EXPECT_TRUE(lab04::almost_equal(1.0, 1.0));
+    EXPECT_TRUE(lab04::almost_equal(1e12, 1e12 + 1e-4));
+    EXPECT_FALSE(lab04::almost_equal(1e12, 1e12 + 1.0));
+    EXPECT_TRUE(lab04::almost_equal(0.0, 1e-15));
+    EXPECT_FALSE(lab04::almost_equal(0.0, std::nan("")));
+    EXPECT_FALSE(lab04::almost_equal(3, 4));
+
+    const std::vector<Point<double>> points{{0.0, 0.0}, {1e12, -1.0}, {2.0, 3.0}};
+    auto nearby = points;
+    nearby[1] = Point<double>{1e12 + 1e-4, -1.0};
+    EXPECT_TRUE(lab04::almost_equal<double>(points, nearby));
+    nearby[2] = Point<double>{2.0, std::nan("")};
+    EXPECT_FALSE(lab04::almost_equal<double>(points, nearby));
+    EXPECT_FALSE(lab04::almost_equal<double>(points, std::span<const Point<double>>{points}.first(2)));
+}
+
+TEST(OrientationTest, IsExactOnNearlyCollinearPoints) {
+    EXPECT_EQ(lab04::orientation(Point<double>{0.0, 0.0}, Point<double>{1.0, 0.0}, Point<double>{0.0, 1.0}), 1);
+    EXPECT_EQ(lab04::orientation(Point<double>{0.0, 0.0}, Point<double>{0.0, 1.0}, Point<double>{1.0, 0.0}), -1);
+    EXPECT_EQ(lab04::orientation(Point<int>{0, 0}, Point<int>{2, 2}, Point<int>{5, 5}), 0);
+
+    const auto batch = near_collinear(2000, 5);
+    std::vector<int> signs(batch.a.size());
+    lab04::orientation<double>(batch.a, batch.b, batch.c, signs);
+    std::size_t collinear = 0;
+    for (std::size_t i = 0; i < signs.size(); ++i) {
+        const auto expected = wide_orientation(batch.a[i], batch.b[i], batch.c[i]);
+        ASSERT_EQ(lab04::orientation(batch.a[i], batch.b[i], batch.c[i]), expected) << i;
+        EXPECT_EQ(signs[i], expected) << i;
+        collinear += expected == 0;
+    }
+    EXPECT_GT(collinear, 0u);
+}
+
+TEST(CompareDistanceTest, IsExactForLargeCoordinates) {
+    const auto batch = near_collinear(2000, 9);
+    std::vector<Point<double>> mirrored;
+    for (std::size_t i = 0; i < batch.a.size(); ++i) {
+        // Reflecting b through a gives an equidistant point; the jittered c is
+        // usually one unit off it.
+        mirrored.emplace_back(2.0 * batch.a[i].x() - batch.b[i].x(), 2.0 * batch.a[i].y() - batch.b[i].y());
+    }
+    std::vector<int> signs(batch.a.size());
+    lab04::compare_distance<double>(batch.a, batch.b, mirrored, signs);
+    for (std::size_t i = 0; i < signs.size(); ++i) {
+        EXPECT_EQ(signs[i], 0) << i;
+        EXPECT_EQ(lab04::compare_distance(batch.a[i], batch.b[i], batch.c[i]),
+                  wide_compare_distance(batch.a[i], batch.b[i], batch.c[i]));
+    }
+
+    std::vector<int> wrong_size(1);
+    EXPECT_THROW(lab04::compare_distance<double>(batch.a, batch.b, mirrored, wrong_size), std::invalid_argument);
+}
+
+TEST(EquidistantTest, KeepsTheIsoscelesTolerance) {
+    const Point<double> apex{0.0, 2.0};
+    EXPECT_TRUE(lab04::equidistant(apex, Point<double>{-1.0, 0.0}, Point<double>{1.0, 0.0}));
+    EXPECT_TRUE(lab04::equidistant(apex, Point<double>{-1.0, 0.0}, Point<double>{1.0 + 1e-15, 0.0}));
+    EXPECT_FALSE(lab04::equidistant(apex, Point<double>{-1.0, 0.0}, Point<double>{1.0 + 1e-9, 0.0}));
+    EXPECT_FALSE(lab04::equidistant(apex, Point<double>{-1.0, 0.0}, Point<double>{1.0 + 1e-15, 0.0}, 0.0));
+
+    const double far = 1e15;
+    EXPECT_NO_THROW((Triangle<double>{Point<double>{far, far + 3.0}, Point<double>{far - 2.0, far},
+                                      Point<double>{far + 2.0, far}}));
+    EXPECT_THROW((Triangle<double>{Point<double>{far, far + 3.0}, Point<double>{far - 2.0, far},
+                                   Point<double>{far + 3.0, far}}),
+                 std::invalid_argument);
+
+    const std::vector<Point<double>> apexes(3, apex);
+    const std::vector<Point<double>> left(3, Point<double>{-1.0, 0.0});
+    const std::vector<Point<double>> right{{1.0, 0.0}, {1.0 + 1e-15, 0.0}, {1.0 + 1e-9, 0.0}};
+    std::vector<unsigned char> equal(3);
+    lab04::equidistant<double>(apexes, left, right, equal);
+    EXPECT_EQ(equal, (std::vector<unsigned char>{1, 1, 0}));
+}
+
+// Types double cannot hold exactly keep their bits on the long double path,
+// where that type is wider than double.
+TEST(PredicateTest, WideTypesAreNotNarrowedToDouble) {
+    if (std::numeric_limits<long double>::digits < 64) {
+        GTEST_SKIP() << "long double is no wider than double here";
+    }
+    constexpr std::int64_t base = std::int64_t{1} << 60;
+    using Wide = Point<std::int64_t>;
+    EXPECT_EQ(lab04::orientation(Wide{base, base}, Wide{base + 1, base + 1}, Wide{base + 2, base + 3}), 1);
+    EXPECT_EQ(lab04::compare_distance(Wide{base, base}, Wide{base + 1, base}, Wide{base + 2, base}), -1);
+
+    using Long = Point<long double>;
+    EXPECT_TRUE(lab04::equidistant(Long{0.0L, 3.0L}, Long{-2.0L, 0.0L}, Long{2.0L, 0.0L}));
+    EXPECT_THROW((Triangle<long double>{Long{0.0L, 3.0L}, Long{-2.0L, 0.0L}, Long{2.0L + 1e-15L, 0.0L}}),
+                 std::invalid_argument);
+}
+
+}  // namespace
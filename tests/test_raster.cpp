@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/raster.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/runtime_polygon.hpp"
+#include "../include/square.hpp"
+#include "../include/task_executor.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::CoverageGrid;
+using lab04::Figure;
+using lab04::Point;
+using lab04::Polygon;
+using lab04::RasterOptions;
+using lab04::Rectangle;
+using lab04::Square;
+using lab04::Triangle;
+using lab04::Viewport;
+
+using Collection = Array<std::shared_ptr<Figure<double>>>;
+
+RasterOptions unit_pixels(std::size_t size) {
+    RasterOptions options;
+    options.width = size;
+    options.height = size;
+    options.tile_size = 4;
+    options.viewport = Viewport{Point<double>{0.0, 0.0}, Point<double>{static_cast<double>(size),
+                                                                       static_cast<double>(size)}};
+    return options;
+}
+
+std::uint64_t total(const CoverageGrid& grid) {
+    std::uint64_t sum = 0;
+    for (std::size_t y = 0; y < grid.height(); ++y) {
+        for (std::size_t x = 0; x < grid.width(); ++x) {
+            sum += grid.at(x, y);
+        }
+    }
+    return sum;
+}
+
+TEST(RasterizeTest, FillsPixelCentersInsideEachFigure) {
+    Collection figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{5.0, 7.0}, 4.0));
+    figures.push_back(nullptr);
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>{5.0, 1.2}, 2.0, 1.0));
+    // L-shape: a non-convex polygon covering five unit cells.
+    figures.push_back(std::make_shared<Polygon<double>>(
+        Polygon<double>{{0.0, 0.0}, {3.0, 0.0}, {3.0, 1.0}, {1.0, 1.0}, {1.0, 3.0}, {0.0, 3.0}}));
+
+    const auto grid = lab04::rasterize(figures, unit_pixels(10));
+    EXPECT_EQ(total(grid), 16u + 2u + 5u);
+    // Row 0 is the top: the square spans y in [5, 9], i.e. rows 1..4.
+    EXPECT_EQ(grid.at(3, 1), 1u);
+    EXPECT_EQ(grid.at(6, 4), 1u);
+    EXPECT_EQ(grid.at(3, 5), 0u);
+    EXPECT_EQ(grid.at(0, 7), 1u);
+    EXPECT_EQ(grid.at(1, 7), 0u);
+    EXPECT_EQ(grid.at(2, 9), 1u);
+    EXPECT_EQ(grid.at(4, 8), 1u);
+    EXPECT_EQ(grid.at(5, 8), 1u);
+    EXPECT_EQ(grid.at(4, 9), 0u);
+}
+
+TEST(RasterizeTest, FillsStarPolygonsByTheEvenOddRule) {
+    std::vector<Point<double>> points;
+    for (int i = 0; i < 5; ++i) {
+        const auto angle = 1.5707963267948966 + 4.0 * 3.141592653589793 * i / 5.0;
+        points.emplace_back(10.0 + 9.0 * std::cos(angle), 10.0 + 9.0 * std::sin(angle));
+    }
+    Collection figures;
+    figures.push_back(std::make_shared<Polygon<double>>(points));
+    const auto grid = lab04::rasterize(figures, unit_pixels(20));
+    // The inner pentagon is left out, the tips are filled.
+    EXPECT_EQ(grid.at(10, 9), 0u);
+    EXPECT_EQ(grid.at(10, 3), 1u);
+}
+
+TEST(RasterizeTest, TilesAndThreadsDoNotChangeTheResult) {
+    std::mt19937 rng{17};
+    std::uniform_real_distribution<double> coordinate{-50.0, 50.0};
+    std::uniform_real_distribution<double> size{0.01, 8.0};
+    Collection figures;
+    for (int i = 0; i < 3000; ++i) {
+        const Point<double> center{coordinate(rng), coordinate(rng)};
+        if (i % 2 == 0) {
+            figures.push_back(std::make_shared<Triangle<double>>(center, size(rng), size(rng)));
+        } else {
+            figures.push_back(std::make_shared<Rectangle<double>>(center, size(rng), size(rng)));
+        }
+    }
+
+    RasterOptions serial;
+    serial.width = 300;
+    serial.height = 200;
+    serial.tile_size = 1024;
+    serial.thread_count = 1;
+    auto tiled = serial;
+    tiled.tile_size = 16;
+    tiled.thread_count = 4;
+
+    const auto expected = lab04::rasterize(figures, serial);
+    const auto actual = lab04::rasterize(figures, tiled);
+    for (std::size_t y = 0; y < expected.height(); ++y) {
+        for (std::size_t x = 0; x < expected.width(); ++x) {
+            ASSERT_EQ(actual.at(x, y), expected.at(x, y)) << x << ',' << y;
+        }
+    }
+    EXPECT_GT(expected.max(), 1u);
+}
+
+TEST(RasterizeTest, CountsFiguresSmallerThanAPixel) {
+    Collection figures;
+    for (int i = 0; i < 100; ++i) {
+        figures.push_back(std::make_shared<Square<double>>(Point<double>{2.25 + 0.001 * i, 3.25}, 0.1));
+    }
+    const auto grid = lab04::rasterize(figures, unit_pixels(8));
+    EXPECT_EQ(grid.at(2, 4), 100u);
+    EXPECT_EQ(total(grid), 100u);
+}
+
+TEST(RasterizeTest, RunsOnAPoolAndStopsWhenAsked) {
+    Collection figures;
+    for (int i = 0; i < 64; ++i) {
+        figures.push_back(std::make_shared<Square<double>>(Point<double>{0.5 + i % 8, 0.5 + i / 8}, 1.0));
+    }
+    lab04::ThreadPool pool{3};
+    const auto grid = lab04::rasterize(figures, unit_pixels(8), pool);
+    ASSERT_TRUE(grid.has_value());
+    EXPECT_EQ(total(*grid), 64u);
+    EXPECT_EQ(grid->max(), 1u);
+
+    std::stop_source stop;
+    stop.request_stop();
+    EXPECT_FALSE(lab04::rasterize(figures, unit_pixels(8), pool, stop.get_token()).has_value());
+}
+
+TEST(RasterizeTest, SkipsFiguresWithNonFiniteOrHugeVertices) {
+    const auto infinity = std::numeric_limits<double>::infinity();
+    Collection figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{2.0, 2.0}, 2.0));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{infinity, 0.0}, 1.0));
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>{0.0, 0.0}, 1e300, 1.0));
+    const auto fitted = lab04::rasterize(figures, unit_pixels(4));
+    EXPECT_GT(total(fitted), 0u);
+
+    auto clipped = unit_pixels(4);
+    clipped.thread_count = 2;
+    const auto grid = lab04::rasterize(figures, clipped);
+    // The square covers four pixels, the huge rectangle the rows it crosses.
+    EXPECT_EQ(grid.at(1, 1), 1u);
+    EXPECT_EQ(grid.at(0, 3), 1u);
+    EXPECT_EQ(total(grid), 4u + 4u);
+}
+
+TEST(RasterImageTest, WritesBinaryNetpbm) {
+    Collection figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{2.0, 2.0}, 2.0));
+    const auto grid = lab04::rasterize(figures, unit_pixels(4));
+
+    std::ostringstream pgm;
+    lab04::write_pgm(pgm, grid);
+    const std::string header = "P5\n4 4\n255\n";
+    ASSERT_EQ(pgm.str().size(), header.size() + 16);
+    EXPECT_EQ(pgm.str().substr(0, header.size()), header);
+    EXPECT_EQ(static_cast<unsigned char>(pgm.str()[header.size()]), 255);
+    EXPECT_EQ(static_cast<unsigned char>(pgm.str()[header.size() + 5]), 0);
+
+    std::ostringstream ppm;
+    lab04::write_ppm(ppm, grid);
+    EXPECT_EQ(ppm.str().size(), std::string{"P6\n4 4\n255\n"}.size() + 48);
+
+    RasterOptions empty;
+    empty.width = 0;
+    EXPECT_THROW(lab04::rasterize(figures, empty), std::invalid_argument);
+}
+
+}  // namespace
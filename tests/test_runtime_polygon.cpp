@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <numbers>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/enclosing.hpp"
+#include "../include/runtime_polygon.hpp"
+#include "../include/square.hpp"
+#include "../include/union_area.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::Point;
+using lab04::Polygon;
+using lab04::Square;
+
+constexpr double kTolerance = 1e-6;
+
+Polygon<double> l_shape() {
+    return Polygon<double>{{0.0, 0.0}, {4.0, 0.0}, {4.0, 1.0}, {1.0, 1.0}, {1.0, 3.0}, {0.0, 3.0}};
+}
+
+TEST(RuntimePolygonTest, RejectsDegenerateInput) {
+    EXPECT_THROW((Polygon<double>{{0.0, 0.0}, {1.0, 1.0}}), std::invalid_argument);
+    EXPECT_THROW((Polygon<double>{{0.0, 0.0}, {1.0, 1.0}, {2.0, 2.0}}), std::invalid_argument);
+}
+
+TEST(RuntimePolygonTest, ConcaveAreaCenterAndContainment) {
+    const auto polygon = l_shape();
+
+    EXPECT_EQ(polygon.vertex_count(), 6U);
+    EXPECT_NEAR(polygon.area(), 6.0, kTolerance);
+    EXPECT_NEAR(polygon.center().x(), 10.0 / 6.0, kTolerance);
+    EXPECT_NEAR(polygon.center().y(), 8.0 / 6.0, kTolerance);
+    EXPECT_TRUE(polygon.contains(Point<double>(0.5, 2.5)));
+    EXPECT_TRUE(polygon.contains(Point<double>(4.0, 0.5)));
+    EXPECT_FALSE(polygon.contains(Point<double>(2.0, 2.0)));
+}
+
+TEST(RuntimePolygonTest, LargeRegularPolygonApproachesCircleArea) {
+    constexpr std::size_t kVertices = 10001;
+    std::vector<Point<double>> points;
+    points.reserve(kVertices);
+    for (std::size_t i = 0; i < kVertices; ++i) {
+        const auto angle = 2.0 * std::numbers::pi * static_cast<double>(i) / kVertices;
+        points.emplace_back(1000.0 + 2.0 * std::cos(angle), -500.0 + 2.0 * std::sin(angle));
+    }
+    const Polygon<double> polygon{std::move(points)};
+
+    const auto expected = 0.5 * kVertices * 4.0 * std::sin(2.0 * std::numbers::pi / kVertices);
+    EXPECT_NEAR(polygon.area(), expected, 1e-8);
+    EXPECT_NEAR(polygon.center().x(), 1000.0, kTolerance);
+    EXPECT_NEAR(polygon.center().y(), -500.0, kTolerance);
+}
+
+TEST(RuntimePolygonTest, ConvexHullAndSimplification) {
+    const auto hull = l_shape().convex_hull();
+    EXPECT_EQ(hull.vertex_count(), 5U);
+    EXPECT_NEAR(hull.area(), 4.0 * 3.0 - 0.5 * 3.0 * 2.0, kTolerance);
+
+    const Polygon<double> noisy{{0.0, 0.0}, {1.0, 0.001}, {2.0, 0.0}, {2.0, 2.0}, {1.0, 2.001}, {0.0, 2.0}};
+    const auto simple = noisy.simplified(0.01);
+    EXPECT_EQ(simple.vertex_count(), 4U);
+    EXPECT_NEAR(simple.area(), 4.0, kTolerance);
+}
+
+TEST(RuntimePolygonTest, HullAgreesWithTheCollectionHullOnNearlyCollinearInput) {
+    // Vertices near 2^50 one unit off the line through the first two; the
+    // rounded cross product cannot tell their turns apart.
+    const double base = 1125899906842624.0;
+    std::vector<Point<double>> points{{base, base}, {base + 4096.0, base + 4096.0 * 3.0}, {base, base + 100000.0}};
+    for (int k = 2; k < 40; ++k) {
+        points.emplace_back(base + 4096.0 * k + (k % 3 - 1), base + 4096.0 * 3.0 * k);
+    }
+    const Polygon<double> polygon{points};
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Polygon<double>>(polygon));
+
+    const auto hull = polygon.convex_hull();
+    const auto expected = lab04::convex_hull(figures);
+    ASSERT_EQ(hull.vertex_count(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(hull.vertex(i).x(), expected[i].x());
+        EXPECT_EQ(hull.vertex(i).y(), expected[i].y());
+    }
+}
+
+TEST(RuntimePolygonTest, SelfIntersectingOutlinesUseTheEvenOddRule) {
+    std::vector<Point<double>> star;
+    for (int i = 0; i < 5; ++i) {
+        const auto angle = std::numbers::pi / 2.0 + 4.0 * std::numbers::pi * i / 5.0;
+        star.emplace_back(std::cos(angle), std::sin(angle));
+    }
+    const Polygon<double> pentagram{star};
+    EXPECT_FALSE(pentagram.contains(Point<double>{0.0, 0.0}));
+    EXPECT_TRUE(pentagram.contains(Point<double>{0.0, 0.8}));
+}
+
+TEST(RuntimePolygonTest, CopyCloneAndEquality) {
+    const auto polygon = l_shape();
+    const auto clone = polygon.clone();
+    const Figure<double>& figure = polygon;
+
+    EXPECT_TRUE(figure == *clone);
+    EXPECT_FALSE(figure == Square<double>(Point<double>(0.0, 0.0), 1.0));
+}
+
+TEST(RuntimePolygonTest, ParticipatesInCollectionUnionArea) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Polygon<double>>(l_shape()));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(0.5, 0.5), 1.0));
+
+    EXPECT_NEAR(lab04::union_area(figures), 6.0, kTolerance);
+}
+
+}  // namespace
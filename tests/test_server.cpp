@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "../include/array.hpp"
+#include "../include/server.hpp"
+#include "../include/square.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::FigureServer;
+using lab04::FigureService;
+
+using Collection = Array<std::shared_ptr<Figure<double>>>;
+
+// Declared after the serving thread so the loop is stopped before the
+// thread is joined, even when an assertion returns early.
+struct StopOnExit {
+    FigureServer<double>& server;
+    ~StopOnExit() { server.stop(); }
+};
+
+std::string run_lines(FigureService<double>& service, std::initializer_list<const char*> lines) {
+    std::string out;
+    for (const auto* line : lines) {
+        service.process_line(line, out);
+    }
+    return out;
+}
+
+std::string exchange(int fd, const std::string& request, std::size_t expected_lines) {
+    EXPECT_EQ(::send(fd, request.data(), request.size(), MSG_NOSIGNAL), static_cast<ssize_t>(request.size()));
+    std::string response;
+    char buffer[4096];
+    while (static_cast<std::size_t>(std::count(response.begin(), response.end(), '\n')) < expected_lines) {
+        const auto count = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (count <= 0) {
+            break;
+        }
+        response.append(buffer, static_cast<std::size_t>(count));
+    }
+    return response;
+}
+
+int connect_loopback(std::uint16_t port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+TEST(FigureServiceTest, AnswersEveryRequestLineInOrder) {
+    Collection figures;
+    FigureService<double> service{figures};
+    const auto out = run_lines(service, {"ADD square 0 0 2", "ADD rectangle 1 0 2 2\r", "", "SIZE", "AREA",
+                                         "UNION", "QUERY 0.5 0", "QUERY 10 10", "ERASE 0", "SIZE"});
+    EXPECT_EQ(out, "OK 0\nOK 1\nOK 2\nOK 8\nOK 6\nOK 2 0 1\nOK 0\nOK 1\nOK 1\n");
+    ASSERT_EQ(figures.size(), 1u);
+    EXPECT_DOUBLE_EQ(figures[0]->center().x(), 1.0);
+}
+
+TEST(FigureServiceTest, QueriesAndAreaFollowInterleavedChanges) {
+    Collection figures;
+    figures.push_back(std::make_shared<lab04::Square<double>>(lab04::Point<double>(0.0, 0.0), 2.0));
+    FigureService<double> service{figures};
+    const auto out = run_lines(service, {"QUERY 0 0", "ADD square 0 0 4", "QUERY 0 0", "AREA", "ERASE 0",
+                                         "QUERY 0 0", "AREA", "ADD square 10 10 1", "QUERY 10 10", "ERASE 0",
+                                         "ERASE 0", "AREA", "QUERY 0 0"});
+    EXPECT_EQ(out, "OK 1 0\nOK 1\nOK 2 0 1\nOK 20\nOK 1\nOK 1 0\nOK 16\nOK 1\nOK 1 1\nOK 1\nOK 0\nOK 0\nOK 0\n");
+}
+
+TEST(FigureServiceTest, ReportsErrorsWithoutDroppingTheConnection) {
+    Collection figures;
+    FigureService<double> service{figures};
+    const auto out =
+        run_lines(service, {"ADD circle 0 0 1", "ADD square 0 0 -1", "ERASE 3", "ERASE x", "PING", "SIZE"});
+    std::size_t errors = 0;
+    for (std::size_t pos = 0; (pos = out.find("ERR ", pos)) != std::string::npos; ++pos) {
+        ++errors;
+    }
+    EXPECT_EQ(errors, 5u);
+    EXPECT_TRUE(out.ends_with("OK 0\n"));
+}
+
+TEST(FigureServerTest, ServesPipelinedRequestsOverUnixSocket) {
+    const auto path = std::filesystem::temp_directory_path() / ("lab04-" + std::to_string(::getpid()) + ".sock");
+    Collection figures;
+    FigureService<double> service{figures};
+    FigureServer<double> server{service, path.string()};
+    std::jthread loop{[&] { server.run(); }};
+    const StopOnExit stop{server};
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+
+    std::string batch;
+    for (int i = 0; i < 500; ++i) {
+        batch += "ADD square " + std::to_string(i * 10) + " 0 2\n";
+    }
+    batch += "SIZE\nAREA\n";
+    const auto response = exchange(fd, batch, 502);
+    EXPECT_TRUE(response.starts_with("OK 0\nOK 1\n"));
+    EXPECT_TRUE(response.ends_with("OK 500\nOK 2000\n"));
+
+    ::close(fd);
+    EXPECT_EQ(figures.size(), 500u);
+}
+
+TEST(FigureServerTest, ListensOnLoopbackTcpOnly) {
+    Collection figures;
+    FigureService<double> service{figures};
+    EXPECT_THROW((FigureServer<double>{service, "0.0.0.0:0"}), std::invalid_argument);
+
+    FigureServer<double> server{service, "127.0.0.1:0"};
+    ASSERT_NE(server.port(), 0);
+    std::jthread loop{[&] { server.run(); }};
+    const StopOnExit stop{server};
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server.port());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+    EXPECT_EQ(exchange(fd, "ADD triangle 0 0 4 3\nAREA\n", 2), "OK 0\nOK 6\n");
+
+    ::close(fd);
+}
+
+TEST(FigureServerTest, ClosesConnectionOnOverlongLine) {
+    Collection figures;
+    FigureService<double> service{figures};
+    lab04::ServerOptions options;
+    options.max_line_length = 1024;
+    FigureServer<double> server{service, "127.0.0.1:0", options};
+    std::jthread loop{[&] { server.run(); }};
+    const StopOnExit stop{server};
+
+    const int fd = connect_loopback(server.port());
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(exchange(fd, "SIZE\n" + std::string(4096, 'x'), 2), "OK 0\nERR request line too long\n");
+    char byte = 0;
+    EXPECT_EQ(::recv(fd, &byte, 1, 0), 0);
+    ::close(fd);
+}
+
+TEST(FigureServerTest, RunsUnionOnThePoolInRequestOrder) {
+    Collection figures;
+    FigureService<double> service{figures};
+    lab04::ThreadPool pool{2};
+    FigureServer<double> server{service, "127.0.0.1:0", {}, &pool};
+    std::jthread loop{[&] { server.run(); }};
+    const StopOnExit stop{server};
+
+    const int first = connect_loopback(server.port());
+    const int second = connect_loopback(server.port());
+    ASSERT_GE(first, 0);
+    ASSERT_GE(second, 0);
+    // Requests after UNION wait for its reply; the figure added behind it is
+    // not part of the area.
+    EXPECT_EQ(exchange(first, "ADD square 0 0 2\nUNION\nADD square 1 0 2\nUNION\nSIZE\n", 5),
+              "OK 0\nOK 4\nOK 1\nOK 6\nOK 2\n");
+    EXPECT_EQ(exchange(second, "UNION\nSIZE\n", 2), "OK 6\nOK 2\n");
+
+    ::close(first);
+    ::close(second);
+}
+
+}  // namespace
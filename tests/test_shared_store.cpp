@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../include/rectangle.hpp"
+#include "../include/runtime_polygon.hpp"
+#include "../include/shared_store.hpp"
+#include "../include/square.hpp"
+#include "../include/task_executor.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Figure;
+using lab04::Point;
+using lab04::Polygon;
+using lab04::Rectangle;
+using lab04::SharedFigureStore;
+using lab04::SharedStoreMode;
+using lab04::SharedStoreOptions;
+using lab04::Square;
+using lab04::Triangle;
+
+SharedStoreOptions small_options() {
+    SharedStoreOptions options;
+    options.shard_count = 3;
+    options.records_per_shard = 64;
+    options.vertices_per_shard = 256;
+    return options;
+}
+
+TEST(SharedStoreTest, SpreadsFiguresAcrossShardsAndLoadsThemBack) {
+    SharedFigureStore<double> store{small_options()};
+    const Square<double> square{Point<double>{0.0, 0.0}, 2.0};
+    const Rectangle<double> rectangle{Point<double>{10.0, 0.0}, 4.0, 2.0};
+    const Triangle<double> triangle{Point<double>{0.0, 10.0}, 2.0, 3.0};
+    const Polygon<double> polygon{{0.0, 0.0}, {3.0, 0.0}, {3.0, 1.0}, {1.0, 1.0}, {1.0, 3.0}, {0.0, 3.0}};
+
+    const auto a = store.insert(square);
+    const auto b = store.insert(rectangle);
+    const auto c = store.insert(triangle);
+    const auto d = store.insert(polygon);
+    EXPECT_EQ(store.size(), 4u);
+    EXPECT_NE(a.shard, b.shard);
+    EXPECT_NE(b.shard, c.shard);
+
+    EXPECT_TRUE(*store.load(a) == square);
+    EXPECT_TRUE(*store.load(b) == rectangle);
+    EXPECT_TRUE(*store.load(c) == triangle);
+    EXPECT_TRUE(*store.load(d) == polygon);
+    EXPECT_NEAR(store.total_area(), 4.0 + 8.0 + 3.0 + 5.0, 1e-9);
+
+    store.erase(b);
+    EXPECT_FALSE(store.contains(b));
+    EXPECT_THROW((void)store.load(b), std::out_of_range);
+    EXPECT_NEAR(store.total_area(), 12.0, 1e-9);
+}
+
+TEST(SharedStoreTest, WindowQueryMergesHitsFromAllShards) {
+    SharedFigureStore<double> store{small_options()};
+    for (int i = 0; i < 30; ++i) {
+        store.insert(Square<double>{Point<double>{static_cast<double>(i) * 10.0, 0.0}, 2.0});
+    }
+    auto hits = store.query_window(Point<double>{25.0, -5.0}, Point<double>{61.0, 5.0});
+    std::vector<double> xs;
+    for (const auto handle : hits) {
+        xs.push_back(store.load(handle)->center().x());
+    }
+    std::sort(xs.begin(), xs.end());
+    EXPECT_EQ(xs, (std::vector<double>{30.0, 40.0, 50.0, 60.0}));
+}
+
+TEST(SharedStoreTest, RestartsCrashedWorkerWithoutLosingData) {
+    SharedFigureStore<double> store{small_options()};
+    for (int i = 0; i < 12; ++i) {
+        store.insert(Square<double>{Point<double>{static_cast<double>(i), 0.0}, 1.0});
+    }
+    const auto victim = store.worker_pid(1);
+    ASSERT_EQ(::kill(victim, SIGKILL), 0);
+
+    EXPECT_NEAR(store.total_area(), 12.0, 1e-9);
+    EXPECT_EQ(store.respawns(), 1u);
+    EXPECT_NE(store.worker_pid(1), victim);
+    EXPECT_EQ(store.query_window(Point<double>{-10.0, -10.0}, Point<double>{20.0, 10.0}).size(), 12u);
+}
+
+TEST(SharedStoreTest, RestartsWorkerReapedByTheSystem) {
+    // With SIGCHLD ignored the kernel reaps workers itself and waitpid()
+    // reports ECHILD; the store must still tell live workers from dead ones.
+    const auto previous = ::signal(SIGCHLD, SIG_IGN);
+    {
+        SharedFigureStore<double> store{small_options()};
+        for (int i = 0; i < 6; ++i) {
+            store.insert(Square<double>{Point<double>{static_cast<double>(i), 0.0}, 1.0});
+        }
+        EXPECT_NEAR(store.total_area(), 6.0, 1e-9);
+        EXPECT_EQ(store.respawns(), 0u);
+
+        const auto victim = store.worker_pid(0);
+        ASSERT_EQ(::kill(victim, SIGKILL), 0);
+        while (::kill(victim, 0) == 0) {
+            ::usleep(1000);
+        }
+        EXPECT_NEAR(store.total_area(), 6.0, 1e-9);
+        EXPECT_EQ(store.respawns(), 1u);
+    }
+    ::signal(SIGCHLD, previous);
+}
+
+// Parent process id of `pid`, read from /proc.
+pid_t parent_of(pid_t pid) {
+    std::ifstream stat{"/proc/" + std::to_string(pid) + "/stat"};
+    std::string line;
+    std::getline(stat, line);
+    std::istringstream fields{line.substr(line.rfind(')') + 1)};
+    char state = 0;
+    pid_t parent = 0;
+    fields >> state >> parent;
+    return parent;
+}
+
+TEST(SharedStoreTest, RestartsWorkersFromTheSpawnerWhileThreadsRun) {
+    SharedFigureStore<double> store{small_options()};
+    lab04::ThreadPool pool{2};
+    for (int i = 0; i < 6; ++i) {
+        store.insert(Square<double>{Point<double>{static_cast<double>(i), 0.0}, 1.0});
+    }
+    const auto spawner = parent_of(store.worker_pid(2));
+    EXPECT_NE(spawner, ::getpid());
+
+    const auto victim = store.worker_pid(2);
+    ASSERT_EQ(::kill(victim, SIGKILL), 0);
+    EXPECT_NEAR(store.total_area(), 6.0, 1e-9);
+    EXPECT_EQ(store.respawns(), 1u);
+    EXPECT_EQ(parent_of(store.worker_pid(2)), spawner);
+}
+
+TEST(SharedStoreTest, ReportsFullStoreAndNamedSegments) {
+    SharedStoreOptions options;
+    options.shard_count = 1;
+    options.records_per_shard = 2;
+    options.vertices_per_shard = 16;
+    options.name = "/lab04-test-" + std::to_string(::getpid());
+    SharedFigureStore<int> store{options};
+    store.insert(Square<int>{Point<int>{0, 0}, 2});
+    store.insert(Square<int>{Point<int>{4, 4}, 2});
+    EXPECT_THROW(store.insert(Square<int>{Point<int>{8, 8}, 2}), std::length_error);
+    EXPECT_NEAR(store.total_area(), 8.0, 1e-9);
+    store.destroy();
+}
+
+TEST(SharedStoreTest, NamedStoreOutlivesItsCoordinator) {
+    SharedStoreOptions options = small_options();
+    options.name = "/lab04-attach-" + std::to_string(::getpid());
+    std::shared_ptr<Figure<double>> kept;
+    lab04::SharedFigureHandle handle;
+    {
+        SharedFigureStore<double> store{options};
+        EXPECT_TRUE(store.created());
+        store.insert(Square<double>{Point<double>{0.0, 0.0}, 2.0});
+        handle = store.insert(Triangle<double>{Point<double>{5.0, 5.0}, 2.0, 3.0});
+        store.erase(store.insert(Square<double>{Point<double>{9.0, 9.0}, 1.0}));
+
+        // One coordinator at a time, and Create never reuses a name.
+        auto second = options;
+        second.mode = SharedStoreMode::OpenOrCreate;
+        EXPECT_THROW(SharedFigureStore<double>{second}, std::runtime_error);
+        EXPECT_THROW(SharedFigureStore<double>{options}, std::system_error);
+    }
+
+    auto reopen = options;
+    reopen.mode = SharedStoreMode::Open;
+    reopen.shard_count = 1;
+    {
+        SharedFigureStore<double> store{reopen};
+        EXPECT_FALSE(store.created());
+        EXPECT_EQ(store.shard_count(), 3u);
+        EXPECT_EQ(store.size(), 2u);
+        EXPECT_NEAR(store.total_area(), 4.0 + 3.0, 1e-9);
+        EXPECT_TRUE(*store.load(handle) == (Triangle<double>{Point<double>{5.0, 5.0}, 2.0, 3.0}));
+        EXPECT_THROW(SharedFigureStore<int>{reopen}, std::runtime_error);
+        store.destroy();
+    }
+    EXPECT_THROW(SharedFigureStore<double>{reopen}, std::system_error);
+}
+
+}  // namespace
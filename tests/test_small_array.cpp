@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "../include/array.hpp"
+#include "../include/square.hpp"
+
+namespace {
+
+using lab04::Figure;
+using lab04::Point;
+using lab04::SmallArray;
+using lab04::Square;
+
+TEST(SmallArrayTest, KeepsSmallContentsInline) {
+    SmallArray<int, 4> values{1, 2, 3};
+    values.push_back(4);
+
+    EXPECT_TRUE(values.is_inline());
+    EXPECT_EQ(values.capacity(), 4U);
+    EXPECT_GE(static_cast<const void*>(values.data()), static_cast<const void*>(&values));
+    EXPECT_LT(static_cast<const void*>(values.data()), static_cast<const void*>(&values + 1));
+}
+
+TEST(SmallArrayTest, SpillsToHeapAndReturnsInlineAfterShrink) {
+    SmallArray<std::string, 2> values;
+    for (int i = 0; i < 10; ++i) {
+        values.push_back(std::to_string(i));
+    }
+    EXPECT_FALSE(values.is_inline());
+    EXPECT_EQ(values.size(), 10U);
+
+    for (int i = 0; i < 8; ++i) {
+        values.erase(values.size() - 1);
+    }
+    values.shrink_to_fit();
+    EXPECT_TRUE(values.is_inline());
+    ASSERT_EQ(values.size(), 2U);
+    EXPECT_EQ(values[0], "0");
+    EXPECT_EQ(values[1], "1");
+}
+
+TEST(SmallArrayTest, CopyAndMovePreserveElementsInBothModes) {
+    SmallArray<std::shared_ptr<Figure<double>>, 2, lab04::ChunkGrowth<8>> figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(0.0, 0.0), 1.0));
+
+    auto copy = figures;
+    auto moved = std::move(figures);
+    EXPECT_TRUE(figures.empty());
+    ASSERT_EQ(moved.size(), 1U);
+    EXPECT_EQ(moved[0], copy[0]);
+
+    for (int i = 0; i < 3; ++i) {
+        moved.push_back(std::make_shared<Square<double>>(Point<double>(i, i), 2.0));
+    }
+    EXPECT_EQ(moved.capacity(), 8U);
+    SmallArray<std::shared_ptr<Figure<double>>, 2, lab04::ChunkGrowth<8>> target;
+    target = std::move(moved);
+    EXPECT_EQ(target.size(), 4U);
+    EXPECT_NEAR(target.back()->area(), 4.0, 1e-9);
+
+    swap(target, copy);
+    EXPECT_EQ(target.size(), 1U);
+    EXPECT_EQ(copy.size(), 4U);
+}
+
+TEST(SmallArrayTest, BoundsAreChecked) {
+    SmallArray<int, 2> values;
+    EXPECT_THROW(values.front(), std::out_of_range);
+    EXPECT_THROW(values.pop_back(), std::out_of_range);
+    values.emplace_back(5);
+    EXPECT_THROW(values.erase(1), std::out_of_range);
+    EXPECT_EQ(values[0], 5);
+}
+
+}  // namespace
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+#include "../include/arena.hpp"
+#include "../include/array.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/runtime_polygon.hpp"
+#include "../include/snapshot.hpp"
+#include "../include/square.hpp"
+#include "../include/triangle.hpp"
+
+namespace {
+
+using lab04::Arena;
+using lab04::Array;
+using lab04::Figure;
+using lab04::Point;
+using lab04::Polygon;
+using lab04::Rectangle;
+using lab04::Square;
+using lab04::Triangle;
+
+using Collection = Array<std::shared_ptr<Figure<double>>>;
+
+Collection make_figures() {
+    Collection figures;
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>{0.0, 0.0}, 4.0, 3.0));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{5.0, 5.0}, 2.0));
+    figures.push_back(nullptr);
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>{-3.0, 1.0}, 6.0, 2.0));
+    figures.push_back(std::make_shared<Polygon<double>>(
+        Polygon<double>{{0.0, 0.0}, {3.0, 0.0}, {3.0, 1.0}, {1.0, 1.0}, {1.0, 3.0}, {0.0, 3.0}}));
+    return figures;
+}
+
+TEST(ArenaTest, BumpsWithinOneBlockAndSpillsToUpstream) {
+    Arena arena{64};
+    void* first = arena.allocate(8, 8);
+    void* second = arena.allocate(16, 16);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(second) % 16, 0u);
+    EXPECT_LT(static_cast<char*>(first), static_cast<char*>(second));
+    EXPECT_EQ(arena.overflow_blocks(), 0u);
+
+    (void)arena.allocate(128, 8);
+    EXPECT_EQ(arena.overflow_blocks(), 1u);
+    EXPECT_LE(arena.used(), arena.capacity());
+}
+
+TEST(DeepSnapshotTest, CopiesEveryFigureIntoOneIsolatedBlock) {
+    auto figures = make_figures();
+    std::size_t footprint = 0;
+    for (const auto& figure : figures) {
+        footprint += figure ? figure->snapshot_footprint() : 0;
+    }
+
+    const auto snapshot = lab04::deep_snapshot(figures);
+    ASSERT_EQ(snapshot.size(), figures.size());
+    EXPECT_EQ(snapshot[2], nullptr);
+
+    const char* lowest = nullptr;
+    const char* highest = nullptr;
+    for (std::size_t i = 0; i < figures.size(); ++i) {
+        if (!figures[i]) {
+            continue;
+        }
+        EXPECT_NE(snapshot[i].get(), figures[i].get());
+        EXPECT_TRUE(*snapshot[i] == *figures[i]);
+        EXPECT_DOUBLE_EQ(snapshot[i]->area(), figures[i]->area());
+        const auto* address = reinterpret_cast<const char*>(snapshot[i].get());
+        lowest = lowest ? std::min(lowest, address) : address;
+        highest = highest ? std::max(highest, address) : address;
+    }
+    EXPECT_EQ(snapshot[0].use_count(), snapshot[4].use_count());
+    EXPECT_LT(static_cast<std::size_t>(highest - lowest), footprint);
+}
+
+TEST(DeepSnapshotTest, OutlivesSourceAndReleasesAsAUnit) {
+    std::shared_ptr<Figure<double>> survivor;
+    std::weak_ptr<Figure<double>> other;
+    {
+        auto figures = make_figures();
+        auto snapshot = lab04::deep_snapshot(figures);
+        figures.clear();
+        survivor = snapshot[4];
+        other = snapshot[0];
+    }
+    ASSERT_TRUE(survivor);
+    EXPECT_NEAR(survivor->area(), 5.0, 1e-12);
+    EXPECT_FALSE(other.expired());
+    survivor.reset();
+    EXPECT_TRUE(other.expired());
+}
+
+TEST(DeepSnapshotTest, CloneIntoUsesTheGivenResource) {
+    const Triangle<double> triangle{Point<double>{0.0, 0.0}, 2.0, 2.0};
+    Arena arena{triangle.snapshot_footprint()};
+    auto* copy = triangle.clone_into(arena);
+    EXPECT_EQ(arena.overflow_blocks(), 0u);
+    EXPECT_LE(arena.used(), triangle.snapshot_footprint());
+    EXPECT_TRUE(*copy == triangle);
+    copy->~Figure<double>();
+}
+
+// Moves a copy placed in a scratch buffer out of it, then wipes the buffer:
+// the moved figure must not have kept anything there.
+template <typename Shape>
+void expect_move_leaves_resource(const Shape& source) {
+    alignas(std::max_align_t) std::array<std::byte, 1024> buffer{};
+    std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+    auto* placed = static_cast<Shape*>(source.clone_into(resource));
+    auto* placed_again = static_cast<Shape*>(source.clone_into(resource));
+    Shape moved{std::move(*placed)};
+    Shape assigned;
+    assigned = std::move(*placed_again);
+    placed->~Shape();
+    placed_again->~Shape();
+    std::fill(buffer.begin(), buffer.end(), std::byte{0xff});
+    EXPECT_TRUE(moved == source);
+    EXPECT_TRUE(assigned == source);
+}
+
+TEST(DeepSnapshotTest, MovedCopiesDoNotKeepSnapshotMemory) {
+    expect_move_leaves_resource(Triangle<double>{Point<double>{0.0, 0.0}, 4.0, 3.0});
+    expect_move_leaves_resource(
+        Polygon<double>{{0.0, 0.0}, {3.0, 0.0}, {3.0, 1.0}, {1.0, 1.0}, {1.0, 3.0}, {0.0, 3.0}});
+}
+
+}  // namespace
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../include/array.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/spatial_order.hpp"
+#include "../include/square.hpp"
+#include "../include/task_executor.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::Point;
+using lab04::Rectangle;
+using lab04::Square;
+
+using Collection = Array<std::shared_ptr<Figure<double>>>;
+
+Collection random_squares(std::size_t count, unsigned seed) {
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<double> coordinate{-500.0, 500.0};
+    Collection figures;
+    for (std::size_t i = 0; i < count; ++i) {
+        figures.push_back(std::make_shared<Square<double>>(Point<double>{coordinate(rng), coordinate(rng)}, 1.0));
+    }
+    return figures;
+}
+
+TEST(MortonKeyTest, InterleavesCoordinateBits) {
+    EXPECT_EQ(lab04::detail::interleave(0b11, 0b00), 0b0101u);
+    EXPECT_EQ(lab04::detail::interleave(0b00, 0b11), 0b1010u);
+    EXPECT_EQ(lab04::detail::interleave(0xFFFFFFFFu, 0xFFFFFFFFu), ~std::uint64_t{0});
+}
+
+TEST(ReorderSpatiallyTest, VisitsQuadrantsInZOrderAndMovesEmptySlotsLast) {
+    Collection figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{10.0, 10.0}, 1.0));
+    figures.push_back(nullptr);
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>{0.0, 10.0}, 2.0, 1.0));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{10.0, 0.0}, 1.0));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{0.0, 0.0}, 1.0));
+    const auto original = figures;
+
+    const auto new_index = lab04::reorder_spatially(figures);
+    EXPECT_EQ(new_index, (std::vector<std::size_t>{3, 4, 2, 1, 0}));
+    for (std::size_t i = 0; i < original.size(); ++i) {
+        EXPECT_EQ(figures[new_index[i]], original[i]);
+    }
+    EXPECT_EQ(figures.back(), nullptr);
+}
+
+TEST(ReorderSpatiallyTest, MovesEmptySlotsBehindTheMaxCornerFigure) {
+    Collection figures;
+    figures.push_back(nullptr);
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{10.0, 10.0}, 1.0));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>{0.0, 0.0}, 1.0));
+    const auto keys = lab04::morton_keys(figures);
+    EXPECT_LT(keys[1], keys[0]);
+
+    const auto new_index = lab04::reorder_spatially(figures);
+    EXPECT_EQ(new_index, (std::vector<std::size_t>{2, 1, 0}));
+    EXPECT_EQ(figures.back(), nullptr);
+}
+
+TEST(ReorderSpatiallyTest, ParallelSortMatchesSerialAndKeysAscend) {
+    auto serial = random_squares(20000, 11);
+    auto parallel = serial;
+    const auto original = serial;
+
+    const auto serial_index = lab04::reorder_spatially(serial, 1);
+    const auto parallel_index = lab04::reorder_spatially(parallel, 4);
+    EXPECT_EQ(serial_index, parallel_index);
+    auto pooled = original;
+    lab04::ThreadPool pool{3};
+    EXPECT_EQ(lab04::reorder_spatially(pooled, pool), serial_index);
+
+    std::vector<bool> seen(original.size(), false);
+    for (std::size_t i = 0; i < original.size(); ++i) {
+        ASSERT_LT(serial_index[i], original.size());
+        EXPECT_FALSE(seen[serial_index[i]]);
+        seen[serial_index[i]] = true;
+        EXPECT_EQ(serial[serial_index[i]], original[i]);
+    }
+
+    const auto keys = lab04::morton_keys(serial);
+    for (std::size_t i = 1; i < keys.size(); ++i) {
+        EXPECT_LE(keys[i - 1], keys[i]);
+    }
+}
+
+}  // namespace
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../include/task_executor.hpp"
+
+namespace {
+
+using lab04::BackgroundTask;
+using lab04::TaskExecutor;
+using lab04::TaskStatus;
+using lab04::ThreadPool;
+
+TEST(ThreadPoolTest, ParallelForVisitsEveryIndexOnce) {
+    ThreadPool pool{4};
+    std::vector<int> visits(10000, 0);
+
+    pool.parallel_for(visits.size(), 64, [&](std::size_t first, std::size_t last) {
+        for (auto i = first; i < last; ++i) {
+            ++visits[i];
+        }
+    });
+
+    EXPECT_EQ(std::accumulate(visits.begin(), visits.end(), 0), 10000);
+    EXPECT_EQ(*std::min_element(visits.begin(), visits.end()), 1);
+}
+
+TEST(ThreadPoolTest, ParallelForRethrowsChunkFailure) {
+    ThreadPool pool{2};
+    EXPECT_THROW(pool.parallel_for(100, 10,
+                                   [](std::size_t first, std::size_t) {
+                                       if (first == 50) {
+                                           throw std::runtime_error("chunk failed");
+                                       }
+                                   }),
+                 std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ShutsDownAfterJobsSubmittedFromManyThreads) {
+    // Workers take jobs while outside threads are still submitting; the pool
+    // must still see its pending count reach zero and let the workers exit.
+    std::atomic<int> done{0};
+    for (int round = 0; round < 20; ++round) {
+        ThreadPool pool{3};
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < 3; ++t) {
+            submitters.emplace_back([&] {
+                for (int i = 0; i < 200; ++i) {
+                    pool.submit([&] { done.fetch_add(1); });
+                }
+            });
+        }
+        for (auto& submitter : submitters) {
+            submitter.join();
+        }
+        while (pool.run_pending_task()) {
+        }
+    }
+    EXPECT_EQ(done.load(), 20 * 3 * 200);
+}
+
+TEST(TaskExecutorTest, CompletedTaskReportsOutputAndProgress) {
+    TaskExecutor executor{2};
+    const auto task = executor.launch("sum", [](BackgroundTask& self) {
+        self.set_total(3);
+        for (int i = 0; i < 3; ++i) {
+            self.append_output("step\n");
+            self.advance();
+        }
+    });
+
+    task->wait();
+    EXPECT_EQ(task->status(), TaskStatus::Completed);
+    EXPECT_DOUBLE_EQ(task->progress(), 1.0);
+    EXPECT_EQ(task->take_output(), "step\nstep\nstep\n");
+    EXPECT_EQ(task->take_output(), "");
+    EXPECT_EQ(executor.find(task->id()), task);
+    executor.forget(task->id());
+    EXPECT_EQ(executor.find(task->id()), nullptr);
+}
+
+TEST(TaskExecutorTest, CancelStopsLongRunningTask) {
+    TaskExecutor executor{2};
+    std::atomic<bool> started{false};
+    const auto task = executor.launch("endless", [&](BackgroundTask& self) {
+        started = true;
+        while (!self.stop_requested()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    while (!started) {
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(task->wait_for(std::chrono::milliseconds(10)));
+    task->cancel();
+    task->wait();
+    EXPECT_EQ(task->status(), TaskStatus::Cancelled);
+}
+
+TEST(TaskExecutorTest, ExceptionMarksTaskFailed) {
+    TaskExecutor executor{1};
+    const auto task = executor.launch("broken", [](BackgroundTask&) { throw std::runtime_error("boom"); });
+
+    task->wait();
+    EXPECT_EQ(task->status(), TaskStatus::Failed);
+    EXPECT_EQ(task->error(), "boom");
+}
+
+}  // namespace
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <stop_token>
+
+#include "../include/array.hpp"
+#include "../include/rectangle.hpp"
+#include "../include/square.hpp"
+#include "../include/task_executor.hpp"
+#include "../include/triangle.hpp"
+#include "../include/union_area.hpp"
+
+namespace {
+
+using lab04::Array;
+using lab04::Figure;
+using lab04::Point;
+using lab04::Rectangle;
+using lab04::Square;
+using lab04::Triangle;
+
+constexpr double kTolerance = 1e-6;
+
+TEST(UnionAreaTest, EmptyCollectionCoversNothing) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(nullptr);
+    EXPECT_NEAR(lab04::union_area(figures), 0.0, kTolerance);
+}
+
+TEST(UnionAreaTest, OverlappingSquaresAreCountedOnce) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(0.0, 0.0), 2.0));
+    figures.push_back(std::make_shared<Square<double>>(Point<double>(1.0, 0.0), 2.0));
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>(0.0, 0.0), 1.0, 1.0));
+
+    EXPECT_NEAR(lab04::union_area(figures), 6.0, kTolerance);
+}
+
+TEST(UnionAreaTest, TriangleAndRectangleOverlapUsesTrapezoids) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>(0.0, 0.0), 4.0, 3.0));
+    figures.push_back(std::make_shared<Rectangle<double>>(Point<double>(0.0, -0.5), 4.0, 1.0));
+
+    EXPECT_NEAR(lab04::union_area(figures), 4.0 + 6.0 - 10.0 / 3.0, kTolerance);
+}
+
+TEST(UnionAreaTest, IdenticalTrianglesCoverSingleArea) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>(1.0, 1.0), 6.0, 4.0));
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>(1.0, 1.0), 6.0, 4.0));
+
+    EXPECT_NEAR(lab04::union_area(figures), 12.0, kTolerance);
+}
+
+TEST(UnionAreaTest, HexagramCrossingsReorderEdgesBetweenSlabs) {
+    // Two equilateral triangles of side 2*sqrt(3) whose edges cross six
+    // times; their union is a hexagram of area 4*sqrt(3).
+    const double root = std::sqrt(3.0);
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>(0.0, 2.0), Point<double>(-root, -1.0),
+                                                         Point<double>(root, -1.0)));
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>(0.0, -2.0), Point<double>(-root, 1.0),
+                                                         Point<double>(root, 1.0)));
+
+    EXPECT_NEAR(lab04::union_area(figures), 4.0 * root, kTolerance);
+    EXPECT_NEAR(lab04::union_area(figures, 3), 4.0 * root, kTolerance);
+}
+
+TEST(UnionAreaTest, StripPartitionedModeMatchesSingleThread) {
+    Array<std::shared_ptr<Figure<double>>> boxes;
+    Array<std::shared_ptr<Figure<double>>> mixed;
+    for (int i = 0; i < 40; ++i) {
+        const Point<double> center{(i * 7 % 23) * 0.5, (i * 11 % 17) * 0.5};
+        boxes.push_back(std::make_shared<Square<double>>(center, 1.0 + i % 3));
+        mixed.push_back(std::make_shared<Rectangle<double>>(center, 2.0, 1.0 + i % 4));
+        mixed.push_back(std::make_shared<Triangle<double>>(center, 3.0, 2.0 + i % 2));
+    }
+
+    EXPECT_NEAR(lab04::union_area(boxes, 4), lab04::union_area(boxes, 1), kTolerance);
+    EXPECT_NEAR(lab04::union_area(mixed, 4), lab04::union_area(mixed, 1), kTolerance);
+    EXPECT_LT(lab04::union_area(mixed), 40 * 2.0 * 2.5 + 40 * 3.0 * 2.5);
+}
+
+TEST(UnionAreaTest, PoolOverloadSweepsStripsAndHonoursStop) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    for (int i = 0; i < 200; ++i) {
+        const Point<double> center{(i * 13 % 37) * 0.5, (i * 7 % 29) * 0.5};
+        figures.push_back(std::make_shared<Square<double>>(center, 1.0 + i % 2));
+        figures.push_back(std::make_shared<Triangle<double>>(center, 2.0, 1.5));
+    }
+
+    lab04::ThreadPool pool{3};
+    const auto area = lab04::union_area(figures, pool);
+    ASSERT_TRUE(area.has_value());
+    EXPECT_NEAR(*area, lab04::union_area(figures), kTolerance);
+
+    std::stop_source stop;
+    stop.request_stop();
+    EXPECT_FALSE(lab04::union_area(figures, pool, stop.get_token()).has_value());
+}
+
+TEST(UnionAreaTest, BoxesUnderTriangleMatchTheirTriangulation) {
+    // The same squares once as boxes, swept by the segment tree, and once as
+    // two right triangles each, swept as general outlines.
+    Array<std::shared_ptr<Figure<double>>> boxes;
+    Array<std::shared_ptr<Figure<double>>> triangles;
+    const Triangle<double> cover{Point<double>(10.0, 10.0), 30.0, 24.0};
+    boxes.push_back(std::make_shared<Triangle<double>>(cover));
+    triangles.push_back(std::make_shared<Triangle<double>>(cover));
+    for (int i = 0; i < 30; ++i) {
+        for (int j = 0; j < 30; ++j) {
+            const double x = i * 0.75;
+            const double y = j * 0.75;
+            const double side = 1.0 + (i + j) % 3 * 0.25;
+            boxes.push_back(std::make_shared<Square<double>>(Point<double>(x, y), side));
+            const Point<double> lower_left{x - side / 2.0, y - side / 2.0};
+            const Point<double> upper_right{x + side / 2.0, y + side / 2.0};
+            triangles.push_back(std::make_shared<Triangle<double>>(
+                Point<double>(upper_right.x(), lower_left.y()), lower_left, upper_right));
+            triangles.push_back(std::make_shared<Triangle<double>>(
+                Point<double>(lower_left.x(), upper_right.y()), lower_left, upper_right));
+        }
+    }
+
+    const auto expected = lab04::union_area(triangles);
+    EXPECT_NEAR(lab04::union_area(boxes), expected, 1e-9 * expected);
+    EXPECT_NEAR(lab04::union_area(boxes, 3), expected, 1e-9 * expected);
+}
+
+TEST(UnionAreaTest, SingleTriangleKeepsBoxSweepScaling) {
+    // 100000 disjoint squares and one triangle beside them: the squares stay
+    // in the segment tree instead of turning into 400000 slab edges.
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.reserve(100001);
+    for (int i = 0; i < 100000; ++i) {
+        figures.push_back(std::make_shared<Square<double>>(Point<double>(2.0 * (i % 500), 2.0 * (i / 500)), 1.0));
+    }
+    figures.push_back(std::make_shared<Triangle<double>>(Point<double>(-10.0, 0.0), 4.0, 3.0));
+
+    EXPECT_NEAR(lab04::union_area(figures), 100000.0 + 6.0, 1e-6);
+}
+
+}  // namespace